@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "bounded_queue.hpp"
+#include "car.hpp"
+
+/*
+AsyncLogger: takes the terminal / pipe I/O off the caller's thread.
+
+    - log() copies the message into a bounded lock-free ring buffer and returns
+    - a background writer thread drains the ring in batches into the real sink
+    - when the ring is full, the OverflowPolicy decides what happens
+    - flush() blocks until everything logged before the call reached the sink
+
+The ring is a BoundedQueue of strings, filled and drained in place so each
+slot keeps its capacity, so producers never take a lock. The mutex / condition variables are only
+used to park the writer when idle and to wait in flush(): the writer
+sleeps without a timeout, and a producer only takes the mutex to wake it
+when it is actually parked.
+
+flush() waits on ring positions, not on message counts: it returns once the
+writer has finished a batch with every position claimed before the call
+written or discarded, so a message is never taken as written while a later
+one dropped under OVERFLOW_DROP_OLDEST stands in for it.
+*/
+
+enum OverflowPolicy {
+    OVERFLOW_BLOCK,       // wait until the writer frees a slot
+    OVERFLOW_DROP_NEWEST, // discard the message being logged
+    OVERFLOW_DROP_OLDEST  // discard the oldest queued message to make room
+};
+
+class AsyncLogger : public ILogger
+{
+    public:
+        AsyncLogger(ILogger* sink,
+                    std::size_t capacity = 1024,
+                    OverflowPolicy policy = OVERFLOW_BLOCK,
+                    std::size_t batch_size = 64)
+            : _sink(sink), _policy(policy), _batch_size(batch_size),
+              _ring(capacity), _done_pos(0), _dropped(0),
+              _running(true), _sleeping(false), _flushers(0) {
+            if (!_sink) {
+                throw std::runtime_error("Sink cannot be null");
+            }
+            _writer = std::thread(&AsyncLogger::_run, this);
+        }
+
+        ~AsyncLogger() {
+            flush();
+            _running.store(false, std::memory_order_seq_cst);
+            _wake_writer();
+            _writer.join();
+        }
+
+        void log(const std::string &message) const {
+            write(message.data(), message.size());
+        }
+
+        void write(const char* data, std::size_t len) const {
+            while (!_ring.push_with(CopyIn(data, len))) {
+                if (_policy == OVERFLOW_DROP_NEWEST) {
+                    _count_dropped();
+                    return;
+                }
+                if (_policy == OVERFLOW_DROP_OLDEST) {
+                    if (_ring.pop_with(Discard())) {
+                        _count_dropped();
+                    }
+                    continue;
+                }
+                _wake_writer();
+                std::this_thread::yield();
+            }
+            _wake_writer();
+        }
+
+        // Returns once every message logged before the call was written or dropped.
+        void flush() const {
+            std::size_t target = _ring.enqueued();
+            _flushers.fetch_add(1, std::memory_order_seq_cst);
+            _wake_writer();
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (_done_pos.load(std::memory_order_seq_cst) < target) {
+                _flushed.wait(lock);
+            }
+            _flushers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        std::size_t dropped() const {
+            return _dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct CopyIn {
+            const char* data;
+            std::size_t len;
+            CopyIn(const char* data, std::size_t len) : data(data), len(len) {}
+            void operator()(std::string& slot) const { slot.assign(data, len); } // reuses the slot's capacity
+        };
+
+        struct ToSink {
+            ILogger* sink;
+            ToSink(ILogger* sink) : sink(sink) {}
+            void operator()(std::string& slot) const { sink->write(slot.data(), slot.size()); }
+        };
+
+        struct Discard {
+            void operator()(std::string&) const {}
+        };
+
+        ILogger* _sink;
+        OverflowPolicy _policy;
+        std::size_t _batch_size;
+        mutable BoundedQueue<std::string> _ring;
+        std::atomic<std::size_t> _done_pos;             // every position before it written or dropped
+        mutable std::atomic<std::size_t> _dropped;
+        std::atomic<bool> _running;
+        mutable std::atomic<bool> _sleeping;            // the writer is parked on _wake
+        mutable std::atomic<std::size_t> _flushers;     // threads waiting in flush()
+        mutable std::mutex _mutex;
+        mutable std::condition_variable _wake;
+        mutable std::condition_variable _flushed;
+        std::thread _writer;
+
+    private:
+        AsyncLogger(const AsyncLogger&);
+        AsyncLogger& operator=(const AsyncLogger&);
+
+        void _count_dropped() const {
+            _dropped.fetch_add(1, std::memory_order_release);
+        }
+
+        // Takes the mutex only if the writer is parked; the fence pairs with the one in _park().
+        void _wake_writer() const {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleeping.load(std::memory_order_relaxed) && _sleeping.exchange(false)) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _wake.notify_one();
+            }
+        }
+
+        std::size_t _drain_batch() {
+            std::size_t n = 0;
+            ToSink to_sink(_sink);
+            while (n < _batch_size && _ring.pop_with(to_sink)) {
+                ++n;
+            }
+            return n;
+        }
+
+        // Between batches the writer holds no slot: every position already claimed
+        // was written by it or discarded by a producer.
+        void _finish_batch() {
+            _done_pos.store(_ring.dequeued(), std::memory_order_seq_cst);
+            if (_flushers.load(std::memory_order_seq_cst)) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _flushed.notify_all();
+            }
+        }
+
+        bool _pending() const {
+            return _ring.claimed();
+        }
+
+        // Sleeps until a producer, flush() or the destructor wakes it; no timeout.
+        void _park() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_pending() || !_running.load(std::memory_order_relaxed)) {
+                _sleeping.store(false, std::memory_order_relaxed);
+                return;
+            }
+            while (_sleeping.load(std::memory_order_relaxed)) {
+                _wake.wait(lock);
+            }
+        }
+
+        void _run() {
+            for (;;) {
+                std::size_t n = _drain_batch();
+                _finish_batch();
+                if (n) {
+                    continue;
+                }
+                if (!_running.load(std::memory_order_acquire)) {
+                    if (!_drain_batch()) {
+                        return;
+                    }
+                    continue;
+                }
+                if (_pending()) {
+                    std::this_thread::yield(); // a producer is still filling the oldest slot
+                    continue;
+                }
+                _park();
+            }
+        }
+};
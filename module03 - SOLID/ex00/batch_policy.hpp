@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define CAR_POLICY_X86 1
+#endif
+
+#include "car_policy.hpp"
+
+/*
+BatchCarPolicy: one PolicyAction evaluated for N cars at once.
+
+Input is columnar, one byte per car per flag (non-zero = set), e.g. straight
+from a fleet's state arrays. Output is an allowed bitmask (bit i%8 of byte
+i/8 is car i) and, optionally, one PolicyReason byte per car.
+
+The 8-entry reason row of CompiledCarPolicy fits in a byte shuffle, so the
+SIMD kernels build the 3-bit state for 16 / 32 cars, look all reasons up
+with one pshufb, and turn `reason == POLICY_OK` into mask bits with
+movemask. The kernel is picked at runtime from what the CPU supports;
+other architectures (and the tail of every batch) use the scalar loop.
+*/
+
+enum BatchKernel { KERNEL_SCALAR, KERNEL_SSSE3, KERNEL_AVX2 };
+
+struct CarStateColumns {
+    const uint8_t* engine_active;
+    const uint8_t* in_park;
+    const uint8_t* braking;
+    std::size_t count;
+};
+
+class BatchCarPolicy
+{
+    public:
+        BatchCarPolicy(const CompiledCarPolicy& policy = CompiledCarPolicy()) {
+            std::memset(_rows, 0, sizeof(_rows));
+            for (unsigned a = 0; a < ACTION_COUNT; ++a) {
+                for (unsigned s = 0; s < STATE_COUNT; ++s) {
+                    _rows[a][s] = (uint8_t)policy.check((PolicyAction)a, s);
+                }
+            }
+        }
+
+        static bool supported(BatchKernel kernel) {
+#ifdef CAR_POLICY_X86
+            if (kernel == KERNEL_AVX2) {
+                return __builtin_cpu_supports("avx2");
+            }
+            if (kernel == KERNEL_SSSE3) {
+                return __builtin_cpu_supports("ssse3");
+            }
+#endif
+            return kernel == KERNEL_SCALAR;
+        }
+
+        static BatchKernel best_kernel() {
+            static const BatchKernel best = supported(KERNEL_AVX2) ? KERNEL_AVX2
+                                          : supported(KERNEL_SSSE3) ? KERNEL_SSSE3 : KERNEL_SCALAR;
+            return best;
+        }
+
+        // allowed: (count + 7) / 8 bytes; reasons: count bytes or NULL.
+        void evaluate(PolicyAction action, const CarStateColumns& cars,
+                      uint8_t* allowed, uint8_t* reasons,
+                      BatchKernel kernel = best_kernel()) const {
+            std::size_t done = 0;
+#ifdef CAR_POLICY_X86
+            if (kernel == KERNEL_AVX2 && supported(KERNEL_AVX2)) {
+                done = _avx2(_rows[action], cars, allowed, reasons);
+            } else if (kernel == KERNEL_SSSE3 && supported(KERNEL_SSSE3)) {
+                done = _ssse3(_rows[action], cars, allowed, reasons);
+            }
+#else
+            (void)kernel;
+#endif
+            _scalar(_rows[action], cars, done, allowed, reasons);
+        }
+
+    private:
+        uint8_t _rows[ACTION_COUNT][16]; // 8 states, padded to one 128-bit lane
+
+    private:
+        // Cars [from, count); `from` is a multiple of 8 so bitmask bytes never straddle kernels.
+        static void _scalar(const uint8_t* row, const CarStateColumns& cars, std::size_t from,
+                            uint8_t* allowed, uint8_t* reasons) {
+            for (std::size_t i = from; i < cars.count; i += 8) {
+                uint8_t bits = 0;
+                for (std::size_t j = i; j < i + 8 && j < cars.count; ++j) {
+                    uint8_t reason = row[car_state(cars.engine_active[j], cars.in_park[j], cars.braking[j])];
+                    if (reasons) {
+                        reasons[j] = reason;
+                    }
+                    bits |= (uint8_t)((reason == POLICY_OK) << (j - i));
+                }
+                allowed[i / 8] = bits;
+            }
+        }
+
+#ifdef CAR_POLICY_X86
+        __attribute__((target("ssse3")))
+        static std::size_t _ssse3(const uint8_t* row, const CarStateColumns& cars,
+                                  uint8_t* allowed, uint8_t* reasons) {
+            const __m128i lut = _mm_loadu_si128((const __m128i*)row);
+            const __m128i one = _mm_set1_epi8(1);
+            const __m128i ok = _mm_setzero_si128();
+            std::size_t i = 0;
+            for (; i + 16 <= cars.count; i += 16) {
+                __m128i a = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(cars.engine_active + i)), one);
+                __m128i p = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(cars.in_park + i)), one);
+                __m128i b = _mm_min_epu8(_mm_loadu_si128((const __m128i*)(cars.braking + i)), one);
+                p = _mm_add_epi8(p, p);
+                b = _mm_add_epi8(b, b);
+                b = _mm_add_epi8(b, b);
+                __m128i state = _mm_or_si128(a, _mm_or_si128(p, b));
+                __m128i reason = _mm_shuffle_epi8(lut, state);
+                if (reasons) {
+                    _mm_storeu_si128((__m128i*)(reasons + i), reason);
+                }
+                uint16_t bits = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(reason, ok));
+                std::memcpy(allowed + i / 8, &bits, sizeof(bits)); // x86 is little-endian
+            }
+            return i;
+        }
+
+        __attribute__((target("avx2")))
+        static std::size_t _avx2(const uint8_t* row, const CarStateColumns& cars,
+                                 uint8_t* allowed, uint8_t* reasons) {
+            const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)row));
+            const __m256i one = _mm256_set1_epi8(1);
+            const __m256i ok = _mm256_setzero_si256();
+            std::size_t i = 0;
+            for (; i + 32 <= cars.count; i += 32) {
+                __m256i a = _mm256_min_epu8(_mm256_loadu_si256((const __m256i*)(cars.engine_active + i)), one);
+                __m256i p = _mm256_min_epu8(_mm256_loadu_si256((const __m256i*)(cars.in_park + i)), one);
+                __m256i b = _mm256_min_epu8(_mm256_loadu_si256((const __m256i*)(cars.braking + i)), one);
+                p = _mm256_add_epi8(p, p);
+                b = _mm256_add_epi8(b, b);
+                b = _mm256_add_epi8(b, b);
+                __m256i state = _mm256_or_si256(a, _mm256_or_si256(p, b));
+                __m256i reason = _mm256_shuffle_epi8(lut, state);
+                if (reasons) {
+                    _mm256_storeu_si256((__m256i*)(reasons + i), reason);
+                }
+                uint32_t bits = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(reason, ok));
+                std::memcpy(allowed + i / 8, &bits, sizeof(bits));
+            }
+            return i;
+        }
+#endif
+};
@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "car_actor.hpp"
+#include "car_policy.hpp"
+#include "fleet.hpp"
+
+// bench/actors [actors] [messages]: CarActorSystem with 10k actors (FleetCars
+// over one fleet, NullLogger, CompiledCarPolicy) and 2 sending threads pushing
+// 4M commands in total, for 1, 2, 4, ... workers up to the hardware thread
+// count (at least 4). Prints messages per second from the first send to the
+// last command run. Each sender owns half of the actors, so every actor's
+// commands arrive in one order and the fleet must end exactly as if they
+// had been applied one by one (exit 1 otherwise).
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t SENDERS = 2;
+
+static CarCommand random_command(uint32_t& seed, uint32_t car) {
+    seed = seed * 1664525u + 1013904223u;
+    uint32_t r = seed >> 8;
+    switch (r % 10) {
+        case 0: return car_command(car, OP_START);
+        case 1: return car_command(car, OP_STOP);
+        case 2: return car_command(car, OP_SHIFT_UP);
+        case 3: return car_command(car, OP_SHIFT_DOWN);
+        case 4: return car_command(car, OP_REVERSE);
+        case 5: return car_command(car, OP_ACCELERATE, (int32_t)(r / 10 % 130));
+        case 6: case 7: return car_command(car, OP_TURN_WHEEL, (int32_t)(r / 10 % 91) - 45);
+        default: return car_command(car, OP_APPLY_BRAKES, (int32_t)(r / 10 % 101));
+    }
+}
+
+// Sender s: commands for actors s, s + SENDERS, s + 2 * SENDERS, ...
+static std::vector<CarCommand> stream(std::size_t s, std::size_t actors, std::size_t count) {
+    std::vector<CarCommand> out(count);
+    uint32_t seed = 42 + (uint32_t)s;
+    std::size_t mine = (actors - s + SENDERS - 1) / SENDERS;
+    for (std::size_t i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t car = (uint32_t)(s + (seed >> 8) % mine * SENDERS);
+        out[i] = random_command(seed, car);
+    }
+    return out;
+}
+
+static bool same_parts(const Fleet& a, const Fleet& b) {
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a.engine_active()[i] != b.engine_active()[i] || a.target_speed()[i] != b.target_speed()[i]
+            || a.gear()[i] != b.gear()[i] || a.forward_gear()[i] != b.forward_gear()[i]
+            || a.steering_angle()[i] != b.steering_angle()[i] || a.brake_force()[i] != b.brake_force()[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::size_t actors = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 10000;
+    std::size_t messages = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 4000000;
+    std::size_t hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    std::size_t most = hardware < 4 ? 4 : hardware;
+    NullLogger null;
+    CompiledCarPolicy policy;
+
+    std::vector<std::vector<CarCommand> > streams;
+    for (std::size_t s = 0; s < SENDERS; ++s) {
+        streams.push_back(stream(s, actors, messages / SENDERS));
+    }
+
+    // Reference: every stream applied directly, one car at a time.
+    Fleet expected(&null, actors);
+    std::vector<std::unique_ptr<FleetCar> > direct;
+    for (std::size_t i = 0; i < actors; ++i) {
+        direct.push_back(std::unique_ptr<FleetCar>(new FleetCar(expected, i, policy)));
+    }
+    for (std::size_t s = 0; s < SENDERS; ++s) {
+        for (std::size_t i = 0; i < streams[s].size(); ++i) {
+            apply_command(direct[streams[s][i].car]->car, streams[s][i]);
+        }
+    }
+
+    std::vector<std::size_t> counts;
+    for (std::size_t workers = 1; workers < most; workers *= 2) {
+        counts.push_back(workers);
+    }
+    counts.push_back(most);
+
+    std::printf("%zu actors, %zu messages from %zu senders, %zu hardware threads\n",
+                actors, messages, SENDERS, hardware);
+    bool ok = true;
+    for (std::size_t k = 0; k < counts.size(); ++k) {
+        Fleet fleet(&null, actors);
+        std::vector<std::unique_ptr<FleetCar> > cars;
+        CarActorSystem system(counts[k]);
+        for (std::size_t i = 0; i < actors; ++i) {
+            cars.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+            system.spawn(cars[i]->car);
+        }
+        system.start();
+
+        Clock::time_point t0 = Clock::now();
+        std::vector<std::thread> senders;
+        for (std::size_t s = 0; s < SENDERS; ++s) {
+            senders.push_back(std::thread([&system, &streams, s] {
+                const std::vector<CarCommand>& mine = streams[s];
+                for (std::size_t i = 0; i < mine.size(); ++i) {
+                    while (!system.send(mine[i].car, mine[i])) {
+                        std::this_thread::yield(); // mailbox full
+                    }
+                }
+            }));
+        }
+        for (std::size_t s = 0; s < SENDERS; ++s) {
+            senders[s].join();
+        }
+        system.wait_idle();
+        double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        system.stop();
+
+        bool same = system.processed() == messages / SENDERS * SENDERS && same_parts(fleet, expected);
+        ok = ok && same;
+        std::printf("%3zu workers %12.0f msgs/s%s%s\n", counts[k], system.processed() / seconds,
+                    counts[k] + SENDERS > hardware ? "  (oversubscribed)" : "", same ? "" : "  DIFFERENT");
+    }
+
+    if (!ok) {
+        std::printf("FAILED: actors diverged from direct application\n");
+        return 1;
+    }
+    return 0;
+}
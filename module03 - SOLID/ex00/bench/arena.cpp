@@ -0,0 +1,185 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "car_command.hpp"
+#include "car_policy.hpp"
+#include "sim_arena.hpp"
+
+// bench/arena [cars] [rounds]: `rounds` (default 20) simulations of `cars`
+// (default 100k) standalone cars (CarParts) and fleet cars (FleetCar), each
+// built, driven through one pass of commands and torn down, once with every
+// car heap-allocated on its own and once through a CarFactory in a
+// SimulationArena. Prints ns per car for each phase; both ways must leave
+// the cars in the same state (exit 1 otherwise).
+
+typedef std::chrono::steady_clock Clock;
+
+struct Phases {
+    double build;
+    double drive;
+    double teardown;
+    long checksum;
+
+    Phases() : build(0), drive(0), teardown(0), checksum(0) {}
+};
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void drive(Car& car, std::size_t i) {
+    car.start();
+    car.shift_gears_up();
+    car.apply_force_on_brakes(0);
+    car.accelerate((int)(i % 120));
+    car.turn_wheel((int)(i % 91) - 45);
+    car.apply_force_on_brakes((int)(i % 101));
+}
+
+static long checksum(const CarParts& p) {
+    return p.engine.get_target_speed() * 7 + p.transmission.get_current_gear() * 3
+        + p.transmission.get_forward_gear() + p.braking_system.get_current_force() * 11
+        + (p.engine.is_active() ? 1 : 0);
+}
+
+static long checksum(const FleetCar& c) {
+    return c.engine.get_target_speed() * 7 + c.transmission.get_current_gear() * 3
+        + c.transmission.get_forward_gear() + c.braking_system.get_current_force() * 11
+        + (c.engine.is_active() ? 1 : 0) + c.steering_system.get_current_angle() * 13;
+}
+
+static void heap_parts(std::size_t cars, ILogger* logger, ICarPolicy& policy, Phases& p) {
+    Clock::time_point t0 = Clock::now();
+    std::vector<std::unique_ptr<CarParts> > all;
+    all.reserve(cars);
+    for (std::size_t i = 0; i < cars; ++i) {
+        all.push_back(std::unique_ptr<CarParts>(new CarParts(logger, policy)));
+    }
+    p.build += since(t0);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < cars; ++i) {
+        drive(all[i]->car, i);
+    }
+    p.drive += since(t0);
+    for (std::size_t i = 0; i < cars; ++i) {
+        p.checksum += checksum(*all[i]);
+    }
+    t0 = Clock::now();
+    all.clear();
+    p.teardown += since(t0);
+}
+
+static void arena_parts(SimulationArena& arena, std::size_t cars, ILogger* logger, ICarPolicy& policy,
+                        std::vector<CarParts*>& all, Phases& p) {
+    Clock::time_point t0 = Clock::now();
+    CarFactory factory(arena, logger, policy);
+    all.clear();
+    for (std::size_t i = 0; i < cars; ++i) {
+        all.push_back(&factory.create());
+    }
+    p.build += since(t0);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < cars; ++i) {
+        drive(all[i]->car, i);
+    }
+    p.drive += since(t0);
+    for (std::size_t i = 0; i < cars; ++i) {
+        p.checksum += checksum(*all[i]);
+    }
+    t0 = Clock::now();
+    arena.reset();
+    p.teardown += since(t0);
+}
+
+static void heap_fleet(Fleet& fleet, ICarPolicy& policy, Phases& p) {
+    std::size_t cars = fleet.size();
+    Clock::time_point t0 = Clock::now();
+    std::vector<std::unique_ptr<FleetCar> > all;
+    all.reserve(cars);
+    for (std::size_t i = 0; i < cars; ++i) {
+        all.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+    }
+    p.build += since(t0);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < cars; ++i) {
+        drive(all[i]->car, i);
+    }
+    p.drive += since(t0);
+    for (std::size_t i = 0; i < cars; ++i) {
+        p.checksum += checksum(*all[i]);
+    }
+    t0 = Clock::now();
+    all.clear();
+    p.teardown += since(t0);
+}
+
+static void arena_fleet(SimulationArena& arena, Fleet& fleet, ICarPolicy& policy, std::vector<FleetCar*>& all,
+                        Phases& p) {
+    std::size_t cars = fleet.size();
+    Clock::time_point t0 = Clock::now();
+    CarFactory factory(arena, fleet.logger(), policy);
+    all.clear();
+    for (std::size_t i = 0; i < cars; ++i) {
+        all.push_back(&factory.create(fleet, i));
+    }
+    p.build += since(t0);
+    t0 = Clock::now();
+    for (std::size_t i = 0; i < cars; ++i) {
+        drive(all[i]->car, i);
+    }
+    p.drive += since(t0);
+    for (std::size_t i = 0; i < cars; ++i) {
+        p.checksum += checksum(*all[i]);
+    }
+    t0 = Clock::now();
+    arena.reset();
+    p.teardown += since(t0);
+}
+
+static void report(const char* name, const Phases& p, double per) {
+    std::printf("%-22s build %6.1f  drive %6.1f  teardown %6.2f ns/car\n", name, p.build * per, p.drive * per,
+                p.teardown * per);
+}
+
+int main(int argc, char** argv) {
+    std::size_t cars = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+    std::size_t rounds = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 20;
+    NullLogger null;
+    CompiledCarPolicy policy;
+    double per = 1e9 / (double)(cars * rounds);
+
+    Phases heap, arena;
+    SimulationArena parts_arena(CarFactory::bytes_for(cars));
+    std::vector<CarParts*> parts;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        heap_parts(cars, &null, policy, heap);
+        arena_parts(parts_arena, cars, &null, policy, parts, arena);
+    }
+    std::printf("%zu cars x %zu rounds; CarParts %zu bytes, FleetCar %zu bytes\n", cars, rounds,
+                sizeof(CarParts), sizeof(FleetCar));
+    report("CarParts, heap", heap, per);
+    report("CarParts, arena", arena, per);
+    bool ok = heap.checksum == arena.checksum && parts_arena.blocks() == 1;
+
+    Phases fleet_heap, fleet_arena;
+    SimulationArena fleet_cars(CarFactory::bytes_for(cars));
+    std::vector<FleetCar*> handles;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        Fleet a(&null, cars);
+        heap_fleet(a, policy, fleet_heap);
+        Fleet b(&null, cars);
+        arena_fleet(fleet_cars, b, policy, handles, fleet_arena);
+    }
+    report("FleetCar, heap", fleet_heap, per);
+    report("FleetCar, arena", fleet_arena, per);
+    ok = ok && fleet_heap.checksum == fleet_arena.checksum && fleet_cars.blocks() == 1;
+
+    if (!ok) {
+        std::printf("FAILED: arena cars differ from heap cars\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "batch_policy.hpp"
+
+// bench/batch_policy [cars]: can_accelerate for a whole fleet (default 2^20 cars,
+// random states) through DefaultCarPolicy in a loop, CompiledCarPolicy in a loop
+// and BatchCarPolicy with each kernel. DefaultCarPolicy's stderr goes to /dev/null.
+
+class FlagEngine : public IEngine
+{
+    public:
+        FlagEngine(bool active = false) : _active(active) {}
+        void start() {}
+        void stop() {}
+        void accelerate(int) {}
+        bool is_active() const { return _active; }
+    private:
+        bool _active;
+};
+
+class FlagTransmission : public ITransmission
+{
+    public:
+        FlagTransmission(bool park = true) : _park(park) {}
+        bool to_park() { return false; }
+        bool to_drive() { return false; }
+        bool to_reverse() { return false; }
+        bool shift_up() { return false; }
+        bool shift_down() { return false; }
+        bool is_in_park() const { return _park; }
+        Gear get_current_gear() const { return _park ? P : D; }
+        int get_forward_gear() const { return _park ? 0 : 1; }
+    private:
+        bool _park;
+};
+
+class FlagBrakes : public IBrakingSystem
+{
+    public:
+        FlagBrakes(bool braking = false) : _braking(braking) {}
+        bool apply_force_on_brakes(int) { return false; }
+        void apply_emergency_brakes() {}
+        int get_current_force() const { return _braking ? 100 : 0; }
+        bool is_braking() const { return _braking; }
+    private:
+        bool _braking;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static void report(const char* name, Clock::time_point t0, std::size_t cars, std::size_t allowed) {
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / cars;
+    std::printf("%-28s %8.3f ns/car  (%zu allowed)\n", name, ns, allowed);
+}
+
+static std::size_t popcount(const std::vector<uint8_t>& bits) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        n += __builtin_popcount(bits[i]);
+    }
+    return n;
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], NULL, 10) : (1 << 20);
+    if (!std::freopen("/dev/null", "w", stderr)) {
+        return 1;
+    }
+
+    std::vector<uint8_t> active(n), park(n), braking(n);
+    std::vector<FlagEngine> engines;
+    std::vector<FlagTransmission> transmissions;
+    std::vector<FlagBrakes> brakes;
+    std::srand(42);
+    for (std::size_t i = 0; i < n; ++i) {
+        active[i] = std::rand() & 1;
+        park[i] = std::rand() & 1;
+        braking[i] = std::rand() & 1;
+        engines.push_back(FlagEngine(active[i]));
+        transmissions.push_back(FlagTransmission(park[i]));
+        brakes.push_back(FlagBrakes(braking[i]));
+    }
+
+    DefaultCarPolicy default_policy;
+    Clock::time_point t0 = Clock::now();
+    std::size_t allowed = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        allowed += default_policy.can_accelerate(engines[i], transmissions[i], brakes[i]);
+    }
+    report("DefaultCarPolicy loop", t0, n, allowed);
+
+    CompiledCarPolicy compiled;
+    t0 = Clock::now();
+    allowed = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        allowed += compiled.can_accelerate(engines[i], transmissions[i], brakes[i]);
+    }
+    report("CompiledCarPolicy loop", t0, n, allowed);
+
+    BatchCarPolicy batch(compiled);
+    CarStateColumns cars = { &active[0], &park[0], &braking[0], n };
+    std::vector<uint8_t> bits((n + 7) / 8), reasons(n), expected(n);
+    batch.evaluate(ACTION_ACCELERATE, cars, &bits[0], &expected[0], KERNEL_SCALAR); // also faults the pages in
+    const BatchKernel kernels[] = { KERNEL_SCALAR, KERNEL_SSSE3, KERNEL_AVX2 };
+    const char* names[] = { "BatchCarPolicy scalar", "BatchCarPolicy SSSE3", "BatchCarPolicy AVX2" };
+    for (int k = 0; k < 3; ++k) {
+        if (!BatchCarPolicy::supported(kernels[k])) {
+            std::printf("%-28s unsupported on this CPU\n", names[k]);
+            continue;
+        }
+        t0 = Clock::now();
+        batch.evaluate(ACTION_ACCELERATE, cars, &bits[0], &reasons[0], kernels[k]);
+        report(names[k], t0, n, popcount(bits));
+        if (reasons != expected) {
+            std::printf("%-28s reasons differ from the scalar kernel!\n", names[k]);
+            return 1;
+        }
+    }
+    return 0;
+}
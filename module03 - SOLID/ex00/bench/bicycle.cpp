@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bicycle.hpp"
+
+// bench/bicycle [cars]: BicycleModel::integrate against BicycleModel::reference
+// (double precision, libm) for random cars (default 2^20).
+//   - one step from identical states: worst error in x, y, heading and yaw
+//     rate, which must stay under the tolerances below (exit 1 otherwise)
+//   - 3600 steps (one simulated minute at 60 Hz) for 1000 cars: worst drift
+//   - ns per car update for both
+
+typedef std::chrono::steady_clock Clock;
+
+static const float DT = 1.0f / 60;
+static const double POSITION_TOLERANCE = 1e-6; // m per step
+static const double ANGLE_TOLERANCE = 1e-5;    // rad, rad/s per step
+
+struct Cars {
+    std::vector<float> speed, heading, x, y, yaw_rate;
+    std::vector<int8_t> angle;
+
+    Cars(std::size_t n) : speed(n), heading(n), x(n), y(n), yaw_rate(n), angle(n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            speed[i] = (float)(std::rand() % 5500 - 1500) / 100;         // -15 .. 40 m/s
+            heading[i] = (float)(std::rand() % 62832 - 31416) / 10000;   // -pi .. pi
+            x[i] = (float)(std::rand() % 2000 - 1000);
+            y[i] = (float)(std::rand() % 2000 - 1000);
+            angle[i] = (int8_t)(std::rand() % 91 - 45);
+        }
+    }
+
+    BicycleColumns columns() {
+        BicycleColumns c = { speed.data(), angle.data(), heading.data(), x.data(), y.data(), yaw_rate.data() };
+        return c;
+    }
+};
+
+static double angle_diff(double a, double b) {
+    double d = std::fabs(a - b);
+    return d > 3.14159265358979323846 ? 2 * 3.14159265358979323846 - d : d;
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], NULL, 10) : (1 << 20);
+    BicycleModel model;
+    std::srand(42);
+
+    // One step from the same state, at the origin so float position resolution does not hide the error.
+    Cars cars(n);
+    std::vector<double> h(n), x(n), y(n), r(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        h[i] = cars.heading[i];
+        cars.x[i] = cars.y[i] = 0;
+    }
+    model.step(cars.columns(), DT, 0, n);
+    double err_pos = 0, err_heading = 0, err_yaw = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        model.reference(cars.speed[i], cars.angle[i], DT, h[i], x[i], y[i], r[i]);
+        err_pos = std::max(err_pos, std::max(std::fabs(cars.x[i] - x[i]), std::fabs(cars.y[i] - y[i])));
+        err_heading = std::max(err_heading, angle_diff(cars.heading[i], h[i]));
+        err_yaw = std::max(err_yaw, std::fabs(cars.yaw_rate[i] - r[i]));
+    }
+    std::printf("one step, %zu cars: max |dx|,|dy| %.2e m  |dheading| %.2e rad  |dyaw| %.2e rad/s\n",
+                n, err_pos, err_heading, err_yaw);
+    bool ok = err_pos < POSITION_TOLERANCE && err_heading < ANGLE_TOLERANCE && err_yaw < ANGLE_TOLERANCE;
+
+    // Drift over a simulated minute.
+    const std::size_t few = 1000, steps = 3600;
+    Cars minute(few);
+    std::vector<double> mh(minute.heading.begin(), minute.heading.end());
+    std::vector<double> mx(minute.x.begin(), minute.x.end()), my(minute.y.begin(), minute.y.end()), mr(few);
+    for (std::size_t s = 0; s < steps; ++s) {
+        model.step(minute.columns(), DT, 0, few);
+        for (std::size_t i = 0; i < few; ++i) {
+            model.reference(minute.speed[i], minute.angle[i], DT, mh[i], mx[i], my[i], mr[i]);
+        }
+    }
+    double drift = 0;
+    for (std::size_t i = 0; i < few; ++i) {
+        drift = std::max(drift, std::hypot(minute.x[i] - mx[i], minute.y[i] - my[i]));
+    }
+    std::printf("%zu steps, %zu cars: max position drift %.3f m\n", steps, few, drift);
+
+    // Throughput.
+    const std::size_t rounds = 50;
+    Clock::time_point t0 = Clock::now();
+    for (std::size_t s = 0; s < rounds; ++s) {
+        model.step(cars.columns(), DT, 0, n);
+    }
+    double kernel = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (rounds * n);
+    t0 = Clock::now();
+    for (std::size_t s = 0; s < rounds; ++s) {
+        for (std::size_t i = 0; i < n; ++i) {
+            model.reference(cars.speed[i], cars.angle[i], DT, h[i], x[i], y[i], r[i]);
+        }
+    }
+    double reference = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (rounds * n);
+    std::printf("%-28s %8.3f ns/car\n%-28s %8.3f ns/car\n", "BicycleModel::integrate", kernel,
+                "BicycleModel::reference", reference);
+
+    if (!ok) {
+        std::printf("FAILED: error above tolerance\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "command_queue.hpp"
+#include "fleet.hpp"
+
+// bench/command_queue [ticks]: a controller stream (default 100000 ticks of
+// 20 commands: mostly steering corrections, speed and brake updates, the odd
+// gear change or reverse) sent to one Car by direct calls and through a
+// CarCommandQueue drained once per tick. Both cars log into a sink that renders
+// each record and drops it.
+// The two cars must end every tick in the same part state (exit 1 otherwise).
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t COMMANDS_PER_TICK = 20;
+
+// A text sink minus the I/O: records are rendered (ILogger::record), then counted.
+class CountingLogger : public ILogger
+{
+    public:
+        CountingLogger() : records(0) {}
+        void log(const std::string&) const { ++records; }
+        void write(const char*, std::size_t) const { ++records; }
+        mutable std::size_t records;
+};
+
+static CarCommand controller_command() {
+    int r = std::rand() % 100;
+    if (r < 50) return car_command(0, OP_TURN_WHEEL, std::rand() % 101 - 50);
+    if (r < 55) return car_command(0, OP_STRAIGHTEN_WHEELS);
+    if (r < 75) return car_command(0, OP_ACCELERATE, std::rand() % 130);
+    if (r < 90) return car_command(0, OP_APPLY_BRAKES, std::rand() % 111 - 5);
+    if (r < 92) return car_command(0, OP_EMERGENCY_BRAKES);
+    if (r < 95) return car_command(0, OP_SHIFT_UP);
+    if (r < 97) return car_command(0, OP_SHIFT_DOWN);
+    if (r < 98) return car_command(0, OP_REVERSE);
+    return car_command(0, r < 99 ? OP_START : OP_STOP);
+}
+
+static bool same_state(const Fleet& a, const Fleet& b) {
+    return a.engine_active()[0] == b.engine_active()[0] && a.target_speed()[0] == b.target_speed()[0]
+        && a.gear()[0] == b.gear()[0] && a.forward_gear()[0] == b.forward_gear()[0]
+        && a.steering_angle()[0] == b.steering_angle()[0] && a.brake_force()[0] == b.brake_force()[0];
+}
+
+int main(int argc, char** argv) {
+    std::size_t ticks = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+    std::vector<CarCommand> stream(ticks * COMMANDS_PER_TICK);
+    std::srand(42);
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        stream[i] = controller_command();
+    }
+    DefaultCarPolicy policy;
+
+    CountingLogger direct_log, queued_log;
+    Fleet direct_fleet(&direct_log, 1), queued_fleet(&queued_log, 1);
+    FleetCar direct(direct_fleet, 0, policy), queued(queued_fleet, 0, policy);
+    CarCommandQueue queue(COMMANDS_PER_TICK);
+    direct_log.records = queued_log.records = 0;
+
+    // Policy rejections print to std::cerr; keep them out of the timing.
+    std::streambuf* cerr = std::cerr.rdbuf(NULL);
+    double direct_ns = 0, queued_ns = 0;
+    std::size_t run = 0;
+    bool ok = true;
+    for (std::size_t t = 0; t < ticks && ok; ++t) {
+        const CarCommand* tick = &stream[t * COMMANDS_PER_TICK];
+        Clock::time_point t0 = Clock::now();
+        for (std::size_t i = 0; i < COMMANDS_PER_TICK; ++i) {
+            apply_command(direct.car, tick[i]);
+        }
+        Clock::time_point t1 = Clock::now();
+        for (std::size_t i = 0; i < COMMANDS_PER_TICK; ++i) {
+            queue.push((CarOp)tick[i].op, tick[i].arg);
+        }
+        run += queue.drain(queued.car).run;
+        Clock::time_point t2 = Clock::now();
+        direct_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        queued_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        if (!same_state(direct_fleet, queued_fleet)) {
+            std::printf("MISMATCH after tick %zu\n", t);
+            ok = false;
+        }
+    }
+    std::cerr.rdbuf(cerr);
+
+    std::size_t n = stream.size();
+    std::printf("%-24s %8.2f ns/command  %6.2f log records/command\n", "direct calls",
+                direct_ns / n, (double)direct_log.records / n);
+    std::printf("%-24s %8.2f ns/command  %6.2f log records/command  (%.1f%% of commands run)\n",
+                "queue, drain per tick", queued_ns / n, (double)queued_log.records / n, 100.0 * run / n);
+
+    if (!ok) {
+        std::printf("FAILED: queued car diverged\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "dynamics.hpp"
+
+// bench/dynamics [car-steps]: VehicleDynamics::step over fleets of 1k, 100k and
+// 1M cars in random part states, each run for about `car-steps` (default 2e8)
+// car updates. Prints fleet steps per second and ns per car update.
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char** argv) {
+    double budget = argc > 1 ? std::atof(argv[1]) : 2e8;
+    static const std::size_t sizes[] = { 1000, 100000, 1000000 };
+    NullLogger null;
+
+    for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        std::size_t cars = sizes[s];
+        Fleet fleet(&null, cars);
+        std::srand(42);
+        for (std::size_t i = 0; i < cars; ++i) {
+            fleet.engine_active()[i] = std::rand() % 4 != 0;
+            fleet.target_speed()[i] = (uint8_t)(std::rand() % 130);
+            fleet.gear()[i] = (uint8_t)(std::rand() % 8 ? D : std::rand() % 2 ? R : P);
+            fleet.brake_force()[i] = (uint8_t)(std::rand() % 10 ? 0 : std::rand() % 101);
+            fleet.steering_angle()[i] = (int8_t)(std::rand() % 91 - 45);
+        }
+        VehicleDynamics dynamics;
+        dynamics.step(fleet); // sizes the state columns
+
+        std::size_t steps = (std::size_t)(budget / cars) + 1;
+        Clock::time_point t0 = Clock::now();
+        for (std::size_t n = 0; n < steps; ++n) {
+            dynamics.step(fleet);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+        double mean_speed = 0;
+        for (std::size_t i = 0; i < cars; ++i) {
+            mean_speed += dynamics.speed()[i];
+        }
+        std::printf("%8zu cars %10.0f steps/s %8.3f ns/car  (mean speed %.2f m/s)\n",
+                    cars, steps / seconds, seconds * 1e9 / (steps * (double)cars), mean_speed / cars);
+    }
+    return 0;
+}
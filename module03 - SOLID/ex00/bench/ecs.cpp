@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "ecs.hpp"
+#include "fleet.hpp"
+
+// bench/ecs [cars]: one frame of random commands (8 per car, default 100k cars)
+// through one Car per car (fleet handles, virtual parts) and through
+// CarWorld + CommandSystem; both log into a NullLogger and use CompiledCarPolicy.
+// The final part states of the two runs must be identical.
+
+typedef std::chrono::steady_clock Clock;
+
+static const std::size_t COMMANDS_PER_CAR = 8;
+
+static double ns_per(Clock::time_point t0, std::size_t n) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+int main(int argc, char** argv) {
+    std::size_t cars = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+    NullLogger null;
+    ILogger* volatile opaque = &null;
+    CompiledCarPolicy policy;
+
+    std::vector<CarCommand> frame(cars * COMMANDS_PER_CAR);
+    std::srand(42);
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        CarOp op = (CarOp)(std::rand() % OP_COUNT);
+        int32_t arg = op == OP_TURN_WHEEL ? std::rand() % 121 - 60
+                    : op == OP_APPLY_BRAKES ? std::rand() % 121 - 10
+                    : op == OP_ACCELERATE ? std::rand() % 120 : 0;
+        frame[i] = car_command((uint32_t)(std::rand() % cars), op, arg);
+    }
+
+    Fleet fleet(opaque, cars);
+    std::vector<std::unique_ptr<FleetCar> > objects;
+    for (std::size_t i = 0; i < cars; ++i) {
+        objects.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+    }
+    Clock::time_point t0 = Clock::now();
+    for (std::size_t i = 0; i < frame.size(); ++i) {
+        apply_command(objects[frame[i].car]->car, frame[i]);
+    }
+    std::printf("%-28s %8.2f ns/command\n", "Car objects", ns_per(t0, frame.size()));
+
+    CarWorld world(opaque);
+    world.reserve(cars);
+    for (std::size_t i = 0; i < cars; ++i) {
+        world.create(); // entity i, slot i
+    }
+    CommandSystem system(policy);
+    t0 = Clock::now();
+    CommandStats stats = system.run(world, frame.data(), frame.size());
+    std::printf("%-28s %8.2f ns/command  (%zu applied, %zu rejected, %zu invalid)\n",
+                "CarWorld CommandSystem", ns_per(t0, frame.size()),
+                stats.applied, stats.rejected, stats.invalid);
+
+    t0 = Clock::now();
+    system.broadcast(world, OP_EMERGENCY_BRAKES);
+    std::printf("%-28s %8.2f ns/car\n", "broadcast emergency brakes", ns_per(t0, cars));
+    for (std::size_t i = 0; i < cars; ++i) {
+        objects[i]->car.apply_emergency_brakes();
+    }
+
+    for (std::size_t i = 0; i < cars; ++i) {
+        if (world.engines()[i].active != fleet.engine_active()[i]
+            || world.engines()[i].target_speed != fleet.target_speed()[i]
+            || world.transmissions()[i].gear != fleet.gear()[i]
+            || world.transmissions()[i].forward != fleet.forward_gear()[i]
+            || world.steering()[i].angle != fleet.steering_angle()[i]
+            || world.brakes()[i].force != fleet.brake_force()[i]) {
+            std::printf("MISMATCH at car %zu\n", i);
+            return 1;
+        }
+    }
+    std::printf("final states identical for %zu cars\n", cars);
+    return 0;
+}
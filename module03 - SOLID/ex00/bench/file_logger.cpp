@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "car.hpp"
+#include "file_logger.hpp"
+
+// bench/file_logger [iterations]: lines/sec of the main.cpp scenario, repeated
+// `iterations` times (default 10^6), through ConsoleLogger and FileLogger.
+// Both write to files in /tmp; policy rejections on stderr are discarded.
+
+class CountingLogger : public ILogger
+{
+    public:
+        CountingLogger(const ILogger& sink) : lines(0), _sink(sink) {}
+        void log(const std::string &message) const {
+            ++lines;
+            _sink.log(message);
+        }
+        void write(const char* data, std::size_t len) const {
+            ++lines;
+            _sink.write(data, len);
+        }
+        mutable std::size_t lines;
+    private:
+        const ILogger& _sink;
+};
+
+static void scenario(Car& car) {
+    car.start();
+    car.shift_gears_up();
+    car.shift_gears_down();
+    car.reverse();
+    car.turn_wheel(30);
+    car.straighten_wheels();
+    car.apply_force_on_brakes(50);
+    car.apply_emergency_brakes();
+    car.stop();
+    car.stop();
+}
+
+static std::FILE* g_report = stdout;
+
+static void run(const char* name, const ILogger& sink, long iterations) {
+    CountingLogger counter(sink);
+    Engine engine(&counter);
+    Transmission transmission(&counter);
+    SteeringSystem steering_system(&counter);
+    BrakingSystem braking_system(&counter);
+    DefaultCarPolicy policy;
+    Car car(&counter, engine, transmission, steering_system, braking_system, policy);
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        scenario(car);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    std::fprintf(g_report, "%-14s %10zu lines %8.3f s %12.0f lines/s\n", name, counter.lines, seconds, counter.lines / seconds);
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+    // Keep a handle on the real stdout for the report, then point ConsoleLogger's
+    // std::cout at a file and drop the policy messages printed on stderr.
+    g_report = fdopen(dup(STDOUT_FILENO), "w");
+    int console_fd = ::open("/tmp/bench_console.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (!g_report || console_fd < 0 || !std::freopen("/dev/null", "w", stderr)) {
+        return 1;
+    }
+    dup2(console_fd, STDOUT_FILENO);
+    ::close(console_fd);
+
+    {
+        ConsoleLogger console;
+        run("ConsoleLogger", console, iterations);
+    }
+    {
+        FileLogger file("/tmp/bench_file.log");
+        run("FileLogger", file, iterations);
+        file.flush();
+        std::fprintf(g_report, "FileLogger syscalls: %zu\n", file.syscalls());
+    }
+    std::fclose(g_report);
+    return 0;
+}
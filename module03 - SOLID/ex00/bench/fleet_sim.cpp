@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "car_policy.hpp"
+#include "fleet_simulator.hpp"
+
+// bench/fleet_sim [cars] [ticks]: FleetSimulator over a fleet (default 100k
+// cars, 120 ticks, commands for a quarter of the cars each tick) with 1, 2,
+// 4, ... threads up to the hardware thread count (at least 4, oversubscribed
+// if need be). Prints ticks per second and speedup over one thread. Every
+// run must end in exactly the state of the one-thread run (exit 1 otherwise).
+
+typedef std::chrono::steady_clock Clock;
+
+struct Outcome {
+    std::vector<uint8_t> parts;
+    std::vector<float> motion;
+};
+
+static CarCommand random_command(std::size_t cars) {
+    uint32_t car = (uint32_t)(std::rand() % cars);
+    int r = std::rand() % 16;
+    switch (r) {
+        case 0: return car_command(car, OP_START);
+        case 1: return car_command(car, OP_STOP);
+        case 2: case 3: case 4: return car_command(car, OP_SHIFT_UP);
+        case 5: return car_command(car, OP_SHIFT_DOWN);
+        case 6: return car_command(car, OP_REVERSE);
+        case 7: case 8: case 9: return car_command(car, OP_ACCELERATE, std::rand() % 130);
+        case 10: case 11: case 12: return car_command(car, OP_TURN_WHEEL, std::rand() % 91 - 45);
+        case 13: return car_command(car, OP_STRAIGHTEN_WHEELS);
+        default: return car_command(car, OP_APPLY_BRAKES, std::rand() % 2 ? 0 : std::rand() % 101);
+    }
+}
+
+static double simulate(std::size_t threads, std::size_t cars, const std::vector<std::vector<CarCommand> >& ticks,
+                       Outcome& out) {
+    NullLogger null;
+    CompiledCarPolicy policy;
+    Fleet fleet(&null, cars);
+    WorkStealingPool pool(threads);
+    FleetSimulator sim(fleet, policy, pool);
+
+    Clock::time_point t0 = Clock::now();
+    for (std::size_t t = 0; t < ticks.size(); ++t) {
+        sim.submit(ticks[t].data(), ticks[t].size());
+        sim.tick();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    out.parts.clear();
+    out.parts.insert(out.parts.end(), fleet.engine_active(), fleet.engine_active() + cars);
+    out.parts.insert(out.parts.end(), fleet.target_speed(), fleet.target_speed() + cars);
+    out.parts.insert(out.parts.end(), fleet.gear(), fleet.gear() + cars);
+    out.parts.insert(out.parts.end(), fleet.forward_gear(), fleet.forward_gear() + cars);
+    out.parts.insert(out.parts.end(), fleet.brake_force(), fleet.brake_force() + cars);
+    const VehicleDynamics& d = sim.dynamics();
+    out.motion.clear();
+    out.motion.insert(out.motion.end(), d.speed(), d.speed() + cars);
+    out.motion.insert(out.motion.end(), d.heading(), d.heading() + cars);
+    out.motion.insert(out.motion.end(), d.x(), d.x() + cars);
+    out.motion.insert(out.motion.end(), d.y(), d.y() + cars);
+    return seconds;
+}
+
+int main(int argc, char** argv) {
+    std::size_t cars = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+    std::size_t tick_count = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 120;
+    std::size_t hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    std::size_t most = hardware < 4 ? 4 : hardware;
+
+    std::vector<std::vector<CarCommand> > ticks(tick_count);
+    std::srand(42);
+    for (std::size_t t = 0; t < tick_count; ++t) {
+        ticks[t].resize(cars / 4);
+        for (std::size_t i = 0; i < ticks[t].size(); ++i) {
+            ticks[t][i] = random_command(cars);
+        }
+    }
+
+    // CompiledCarPolicy prints nothing, but keep stray diagnostics out of the timing.
+    std::streambuf* cerr = std::cerr.rdbuf(NULL);
+    Outcome reference;
+    double base = simulate(1, cars, ticks, reference);
+    std::printf("%zu cars, %zu ticks, %zu hardware threads\n", cars, tick_count, hardware);
+    std::printf("%3s threads %10.1f ticks/s  speedup %5.2f\n", "1", tick_count / base, 1.0);
+
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 2; threads < most; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(most);
+
+    bool ok = true;
+    for (std::size_t k = 0; k < counts.size(); ++k) {
+        std::size_t threads = counts[k];
+        Outcome run;
+        double seconds = simulate(threads, cars, ticks, run);
+        bool same = run.parts == reference.parts
+            && std::memcmp(run.motion.data(), reference.motion.data(), run.motion.size() * sizeof(float)) == 0;
+        ok = ok && same;
+        std::printf("%3zu threads %10.1f ticks/s  speedup %5.2f%s%s\n", threads, tick_count / seconds,
+                    base / seconds, threads > hardware ? "  (oversubscribed)" : "", same ? "" : "  DIFFERENT");
+    }
+    std::cerr.rdbuf(cerr);
+
+    if (!ok) {
+        std::printf("FAILED: results depend on the thread count\n");
+        return 1;
+    }
+    std::printf("identical results for every thread count\n");
+    return 0;
+}
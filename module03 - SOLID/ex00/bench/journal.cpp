@@ -0,0 +1,229 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "car_command.hpp"
+#include "car_policy.hpp"
+#include "fleet.hpp"
+#include "state_journal.hpp"
+
+// bench/journal [events] [cars]: StateJournal in two parts, files in /tmp.
+//
+// 1. A fleet of 20k cars driven by random commands through FleetCars for 200
+//    ticks, with and without a journal attached: the journal's cost per
+//    command, then every tick the fleet was copied at rebuilt from the
+//    journal (whole fleet and single cars) and compared.
+// 2. `events` (default 10^8) random state changes over `cars` (default 100k)
+//    cars in ticks of `cars` events, snapshot every 64 ticks: the state as of
+//    the last tick rebuilt from the nearest snapshot, then from scratch
+//    (snapshots removed), in events per second.
+//
+// Exit 1 if any rebuilt state differs from the one recorded.
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* JOURNAL_PATH = "/tmp/car_bench.journal";
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void remove_journal() {
+    std::remove(JOURNAL_PATH);
+    std::remove((std::string(JOURNAL_PATH) + ".snap").c_str());
+}
+
+static CarCommand random_command(uint32_t& seed, std::size_t cars) {
+    seed = seed * 1664525u + 1013904223u;
+    uint32_t r = seed >> 8;
+    uint32_t car = (uint32_t)(r % cars);
+    r /= (uint32_t)cars;
+    switch (r % 10) {
+        case 0: return car_command(car, OP_START);
+        case 1: return car_command(car, OP_STOP);
+        case 2: case 3: return car_command(car, OP_SHIFT_UP);
+        case 4: return car_command(car, OP_SHIFT_DOWN);
+        case 5: return car_command(car, OP_ACCELERATE, (int32_t)(r / 10 % 130));
+        case 6: case 7: return car_command(car, OP_TURN_WHEEL, (int32_t)(r / 10 % 91) - 45);
+        default: return car_command(car, OP_APPLY_BRAKES, (int32_t)(r / 10 % 101));
+    }
+}
+
+static bool same_fleet(const JournalState& s, const std::vector<uint8_t>& fleet, std::size_t cars) {
+    if (s.size() > cars) {
+        return false;
+    }
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        for (std::size_t i = 0; i < cars; ++i) {
+            uint8_t v = i < s.size() ? s.column((StateField)f)[i] : 0;
+            if (v != fleet[f * cars + i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void copy_fleet(const Fleet& fleet, std::vector<uint8_t>& out) {
+    std::size_t n = fleet.size();
+    out.resize(FIELD_COUNT * n);
+    std::memcpy(&out[FIELD_ENGINE_ACTIVE * n], fleet.engine_active(), n);
+    std::memcpy(&out[FIELD_TARGET_SPEED * n], fleet.target_speed(), n);
+    std::memcpy(&out[FIELD_GEAR * n], fleet.gear(), n);
+    std::memcpy(&out[FIELD_FORWARD_GEAR * n], fleet.forward_gear(), n);
+    std::memcpy(&out[FIELD_STEERING_ANGLE * n], fleet.steering_angle(), n);
+    std::memcpy(&out[FIELD_BRAKE_FORCE * n], fleet.brake_force(), n);
+}
+
+// Part 1; returns false on a mismatch.
+static bool fleet_journal() {
+    const std::size_t cars = 20000;
+    const std::size_t ticks = 200;
+    const std::size_t per_tick = 10000;
+    static const std::size_t CHECKED[] = { 0, 15, 16, 17, 100, 127, 128, 199 };
+    const std::size_t checked = sizeof(CHECKED) / sizeof(CHECKED[0]);
+    NullLogger null;
+    CompiledCarPolicy policy;
+
+    double seconds[2];
+    std::vector<std::vector<uint8_t> > copies(checked);
+    uint64_t events = 0;
+    for (int journaled = 0; journaled < 2; ++journaled) {
+        Fleet fleet(&null, cars);
+        std::vector<std::unique_ptr<FleetCar> > handles;
+        for (std::size_t i = 0; i < cars; ++i) {
+            handles.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+        }
+        std::unique_ptr<StateJournal> journal;
+        if (journaled) {
+            journal.reset(new StateJournal(JOURNAL_PATH, 16));
+            fleet.journal_to(journal.get());
+        }
+        uint32_t seed = 7;
+        std::size_t next = 0;
+        Clock::time_point t0 = Clock::now();
+        for (std::size_t t = 0; t < ticks; ++t) {
+            for (std::size_t i = 0; i < per_tick; ++i) {
+                CarCommand c = random_command(seed, cars);
+                apply_command(handles[c.car]->car, c);
+            }
+            if (journal) {
+                journal->tick();
+                if (next < checked && CHECKED[next] == t) {
+                    copy_fleet(fleet, copies[next++]);
+                }
+            }
+        }
+        seconds[journaled] = since(t0);
+        if (journal) {
+            journal->flush();
+            events = journal->events();
+        }
+    }
+    std::size_t commands = ticks * per_tick;
+    std::printf("fleet: %zu commands, %llu journal events: %.1f ns/command plain, %.1f journaled\n", commands,
+                (unsigned long long)events, seconds[0] * 1e9 / commands, seconds[1] * 1e9 / commands);
+
+    JournalReplay replay(JOURNAL_PATH);
+    bool ok = replay.snapshots() == ticks / 16;
+    JournalState state;
+    for (std::size_t k = 0; k < checked; ++k) {
+        replay.rebuild(CHECKED[k], state);
+        ok = ok && same_fleet(state, copies[k], cars);
+        for (std::size_t i = 0; i < cars; i += 997) {
+            JournalCarState one = replay.car_at(CHECKED[k], (uint32_t)i);
+            for (int f = 0; f < FIELD_COUNT; ++f) {
+                ok = ok && (uint8_t)one.value[f] == copies[k][f * cars + i];
+            }
+        }
+    }
+    std::printf("fleet: %zu ticks rebuilt from %zu snapshots: %s\n", checked, replay.snapshots(),
+                ok ? "identical" : "DIFFERENT");
+    return ok;
+}
+
+// Part 2; returns false on a mismatch.
+static bool replay_throughput(uint64_t events, std::size_t cars) {
+    JournalState expected;
+    uint64_t ticks;
+    {
+        StateJournal journal(JOURNAL_PATH, 64);
+        uint32_t seed = 11;
+        Clock::time_point t0 = Clock::now();
+        for (uint64_t i = 1; i <= events; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            uint32_t r = seed >> 8;
+            StateField field = (StateField)(r % FIELD_COUNT);
+            journal.append(r / FIELD_COUNT % (uint32_t)cars, field,
+                           field == FIELD_STEERING_ANGLE ? (int)(r >> 16) % 91 - 45 : (int)(r >> 16) % 101);
+            if (i % cars == 0) {
+                journal.tick();
+            }
+        }
+        journal.tick();
+        journal.flush();
+        ticks = journal.ticks();
+        expected = journal.state();
+        double seconds = since(t0);
+        std::printf("journal: %llu events in %llu ticks written in %.2f s (%.0f events/s)\n",
+                    (unsigned long long)journal.events(), (unsigned long long)ticks, seconds,
+                    journal.events() / seconds);
+    }
+
+    bool ok = true;
+    JournalState state;
+    {
+        JournalReplay replay(JOURNAL_PATH);
+        Clock::time_point t0 = Clock::now();
+        replay.rebuild(ticks - 1, state);
+        std::printf("journal: last tick from the nearest of %zu snapshots in %.3f s\n", replay.snapshots(),
+                    since(t0));
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            ok = ok && state.size() == expected.size()
+                && std::memcmp(state.column((StateField)f), expected.column((StateField)f), state.size()) == 0;
+        }
+
+        const int queries = 100;
+        t0 = Clock::now();
+        for (int q = 0; q < queries; ++q) {
+            replay.car_at((uint64_t)q * 7919 % ticks, (uint32_t)(q * 104729 % cars));
+        }
+        std::printf("journal: one car at a random tick in %.2f ms\n", since(t0) * 1e3 / queries);
+    }
+
+    std::remove((std::string(JOURNAL_PATH) + ".snap").c_str());
+    {
+        JournalReplay replay(JOURNAL_PATH);
+        Clock::time_point t0 = Clock::now();
+        replay.rebuild(ticks - 1, state);
+        double seconds = since(t0);
+        std::printf("journal: last tick from scratch in %.2f s (%.0f events/s)\n", seconds,
+                    replay.events() / seconds);
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            ok = ok && state.size() == expected.size()
+                && std::memcmp(state.column((StateField)f), expected.column((StateField)f), state.size()) == 0;
+        }
+    }
+    std::printf("journal: rebuilt state %s\n", ok ? "identical" : "DIFFERENT");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint64_t events = argc > 1 ? std::strtoull(argv[1], NULL, 10) : 100000000ULL;
+    std::size_t cars = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 100000;
+
+    bool ok = fleet_journal();
+    remove_journal();
+    ok = replay_throughput(events, cars) && ok;
+    remove_journal();
+
+    if (!ok) {
+        std::printf("FAILED: the journal does not rebuild the recorded state\n");
+        return 1;
+    }
+    return 0;
+}
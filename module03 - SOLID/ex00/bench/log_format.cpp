@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "car.hpp"
+
+// Counts every global heap allocation made while a benchmark runs.
+static std::size_t g_allocations = 0;
+
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static const int ITERATIONS = 1000000;
+
+// Keeps ILogger's default record(), so events are still rendered to text.
+class DiscardLogger : public ILogger
+{
+    public:
+        void log(const std::string &) const {}
+        void write(const char*, std::size_t) const {}
+};
+
+// The formatting LoggerMixin::log used to do: temporaries plus concatenations.
+static void legacy_accelerate(const ILogger& sink, int speed) {
+    std::string class_name = Engine::class_name;
+    std::string color = LogColor<Engine>::color();
+    std::string m = "Accelerating to " + std::to_string(speed) + " km/h.";
+    sink.log(color + class_name + ": " + m + ansi::RESET);
+}
+
+template <typename F>
+static void run(const char* name, F f) {
+    std::size_t before = g_allocations;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        f(i);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / ITERATIONS;
+    double allocs = (double)(g_allocations - before) / ITERATIONS;
+    std::printf("%-24s %8.1f ns/call %8.2f allocs/call\n", name, ns, allocs);
+}
+
+int main() {
+    DiscardLogger sink;
+    Engine engine(&sink);
+    engine.start();
+
+    run("legacy concatenation", [&](int i) { legacy_accelerate(sink, i); });
+    run("LogBuffer", [&](int i) { engine.accelerate(i); });
+    return 0;
+}
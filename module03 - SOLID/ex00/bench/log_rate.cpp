@@ -0,0 +1,178 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "car.hpp"
+
+// bench/log_rate: LogRate sampling, token bucket, exemption and the
+// "suppressed N messages" summary, checked on Engine events; then the cost
+// of an event the limiter drops.
+
+// Counts records by event and keeps the text of the last summary.
+class CountingLogger : public ILogger
+{
+    public:
+        CountingLogger() { reset(); }
+
+        void log(const std::string &) const {}
+        void write(const char*, std::size_t) const {}
+
+        void record(const LogRecord& r) const {
+            ++_count[r.event];
+            if (r.event == EV_LOG_SUPPRESSED) {
+                LogBuffer& line = LogBuffer::local();
+                line.clear();
+                render_record(line, r);
+                _summary.assign(line.data(), line.size());
+                _suppressed += r.args[0];
+            }
+        }
+
+        void reset() {
+            for (int i = 0; i < EV_COUNT; ++i) {
+                _count[i] = 0;
+            }
+            _summary.clear();
+            _suppressed = 0;
+        }
+
+        long count(LogEvent ev) const { return _count[ev]; }
+        long suppressed() const { return _suppressed; }
+        const std::string& summary() const { return _summary; }
+
+    private:
+        mutable long _count[EV_COUNT];
+        mutable long _suppressed;
+        mutable std::string _summary;
+};
+
+static bool g_ok = true;
+
+static void expect(const char* what, long got, long expected) {
+    std::printf("%-48s %6ld  (expected %ld)\n", what, got, expected);
+    if (got != expected) {
+        std::printf("MISMATCH: %s\n", what);
+        g_ok = false;
+    }
+}
+
+static void expect_text(const char* what, const std::string& line, const char* text) {
+    bool found = line.find(text) != std::string::npos;
+    std::printf("%-48s %s\n", what, found ? text : "(missing)");
+    if (!found) {
+        std::printf("MISMATCH: %s: \"%s\" not in \"%s\"\n", what, text, line.c_str());
+        g_ok = false;
+    }
+}
+
+static LogRateConfig& engine_rate(unsigned long sample_every, double per_second, double burst,
+                                  std::chrono::milliseconds summary_every) {
+    LogRateConfig& c = LogRate<Engine>::config();
+    c.sample_every = sample_every;
+    c.per_second = per_second;
+    c.burst = burst;
+    c.exempt_from = LOG_WARN;
+    c.summary_every = summary_every;
+    return c;
+}
+
+static const std::chrono::milliseconds HOUR(3600 * 1000);
+
+// The limiter counts every event it sees, so the engine is built and started unlimited.
+static void limits_off() {
+    engine_rate(1, 0, 0, HOUR);
+}
+
+int main() {
+    CountingLogger sink;
+
+    // 1 in 10 kept; nothing is due within the hour, flush_suppressed() reports the rest.
+    {
+        limits_off();
+        Engine engine(&sink);
+        engine.start();
+        engine_rate(10, 0, 0, HOUR);
+        sink.reset();
+        for (int i = 0; i < 1000; ++i) {
+            engine.accelerate(i % 200);
+        }
+        expect("sampling 1/10: events kept of 1000", sink.count(EV_ENGINE_ACCELERATING), 100);
+        expect("sampling 1/10: summaries before flush", sink.count(EV_LOG_SUPPRESSED), 0);
+        engine.flush_suppressed();
+        expect("sampling 1/10: suppressed after flush", sink.suppressed(), 900);
+        expect_text("sampling 1/10: summary text", sink.summary(), "suppressed 900 messages");
+    }
+
+    // Burst 5 at 1 token/s: the loop takes far less than a second, so exactly 5 pass.
+    {
+        limits_off();
+        Engine engine(&sink);
+        engine.start();
+        engine_rate(1, 1, 5, HOUR);
+        sink.reset();
+        for (int i = 0; i < 2000; ++i) {
+            engine.accelerate(i % 200);
+        }
+        expect("token bucket 1/s, burst 5: kept of 2000", sink.count(EV_ENGINE_ACCELERATING), 5);
+        engine.flush_suppressed();
+        expect_text("token bucket: summary text, comma-grouped", sink.summary(), "suppressed 1,995 messages");
+    }
+
+    // Warnings are exempt: a stopped engine's refusals all pass, sampled or not.
+    {
+        limits_off();
+        Engine engine(&sink);
+        engine_rate(10, 1, 1, HOUR);
+        sink.reset();
+        for (int i = 0; i < 1000; ++i) {
+            engine.accelerate(i);
+        }
+        expect("exempt warnings kept of 1000", sink.count(EV_ENGINE_NOT_RUNNING), 1000);
+        expect("exempt warnings suppressed", sink.suppressed(), 0);
+    }
+
+    // The summary goes out with the first event once summary_every has passed, not before.
+    {
+        limits_off();
+        Engine engine(&sink);
+        engine.start();
+        engine_rate(10, 0, 0, std::chrono::milliseconds(200));
+        sink.reset();
+        for (int i = 0; i < 100; ++i) {
+            engine.accelerate(i);
+        }
+        expect("summary timing: summaries within the window", sink.count(EV_LOG_SUPPRESSED), 0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        expect("summary timing: summaries with no new event", sink.count(EV_LOG_SUPPRESSED), 0);
+        engine.accelerate(100);
+        expect("summary timing: summaries after the next event", sink.count(EV_LOG_SUPPRESSED), 1);
+        expect("summary timing: suppressed in that summary", sink.suppressed(), 90);
+        expect_text("summary timing: summary text", sink.summary(), "suppressed 90 messages");
+    }
+
+    // What a dropped event costs next to an unlimited one.
+    {
+        const int events = 10000000;
+        NullLogger null;
+        ILogger* volatile opaque = &null; // keep the limiter: a NullLogger known at compile time skips it
+        for (int limited = 0; limited < 2; ++limited) {
+            limits_off();
+            Engine engine(opaque);
+            engine.start();
+            engine_rate(limited ? 1000 : 1, 0, 0, HOUR);
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (int i = 0; i < events; ++i) {
+                engine.accelerate(i & 127);
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            std::printf("%-48s %6.2f ns/event\n", limited ? "sampled 1/1000 (mostly dropped)" : "unlimited", ns / events);
+        }
+    }
+
+    if (!g_ok) {
+        std::printf("FAILED: rate limiting does not behave as configured\n");
+        return 1;
+    }
+    return 0;
+}
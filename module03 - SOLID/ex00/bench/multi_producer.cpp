@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "car.hpp"
+#include "multi_producer_logger.hpp"
+
+// bench/multi_producer [messages per thread]: throughput of component logging
+// from 1 to 64 threads, each driving its own Engine, through
+//   - a global mutex around the sink (what ILogger needs today)
+//   - MultiProducerLogger (per-thread staging, one merging consumer)
+// The sink only counts lines, so the numbers are the logging overhead.
+
+class CountingSink : public ILogger
+{
+    public:
+        CountingSink() : lines(0) {}
+        void log(const std::string &) const { ++lines; }
+        void write(const char*, std::size_t) const { ++lines; }
+        mutable std::size_t lines;
+};
+
+class MutexLogger : public ILogger
+{
+    public:
+        MutexLogger(ILogger* sink) : _sink(sink) {}
+        void log(const std::string &message) const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _sink->log(message);
+        }
+        void write(const char* data, std::size_t len) const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _sink->write(data, len);
+        }
+    private:
+        ILogger* _sink;
+        mutable std::mutex _mutex;
+};
+
+static void produce(ILogger* logger, long messages) {
+    Engine engine(logger);
+    engine.start();
+    for (long i = 1; i < messages - 1; ++i) {
+        engine.accelerate((int)i);
+    }
+}
+
+template <typename MakeLogger>
+static double run(int threads, long messages, MakeLogger make) {
+    CountingSink sink;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    {
+        std::unique_ptr<ILogger> logger(make(&sink));
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.push_back(std::thread(produce, logger.get(), messages));
+        }
+        for (std::size_t t = 0; t < producers.size(); ++t) {
+            producers[t].join();
+        }
+    } // MultiProducerLogger flushes on destruction
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    return sink.lines / std::chrono::duration<double>(t1 - t0).count();
+}
+
+static ILogger* make_mutex(ILogger* sink) { return new MutexLogger(sink); }
+static ILogger* make_merging(ILogger* sink) { return new MultiProducerLogger(sink); }
+
+int main(int argc, char** argv) {
+    long messages = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    std::printf("%8s %18s %18s\n", "threads", "mutex lines/s", "merging lines/s");
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        double locked = run(threads, messages, make_mutex);
+        double merging = run(threads, messages, make_merging);
+        std::printf("%8d %18.0f %18.0f\n", threads, locked, merging);
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "car_policy.hpp"
+#include "fleet.hpp"
+#include "scenario.hpp"
+
+// bench/scenarios [scenarios] [laps]: one coroutine scenario per car of a
+// fleet (default 200k), each driving `laps` (default 10) rounds of "pull
+// away, wait, turn, wait, brake, wait" with per-car waits, under one
+// ScenarioScheduler on 1, 2, 4, ... threads up to the hardware thread count
+// (at least 4). Prints resumes per second (wall clock) and the simulated
+// time covered. Every run must leave the fleet exactly as the one-thread
+// run does (exit 1 otherwise). Built with -std=c++20, see the Makefile.
+
+typedef std::chrono::steady_clock Clock;
+
+static Scenario commute(Car& car, uint32_t seed, std::size_t laps) {
+    car.start();
+    for (std::size_t lap = 0; lap < laps; ++lap) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t r = seed >> 8;
+        car.shift_gears_up();
+        car.apply_force_on_brakes(0);
+        car.accelerate((int)(30 + r % 90));
+        co_await wait_for(SimDuration(500 + r % 1500));
+        car.turn_wheel((int)(r / 7 % 91) - 45);
+        co_await wait_for(std::chrono::seconds(2));
+        car.straighten_wheels();
+        car.apply_force_on_brakes((int)(40 + r / 13 % 61));
+        co_await wait_for(SimDuration(250 + r / 17 % 750));
+        car.stop();
+        car.start();
+    }
+    car.stop();
+}
+
+struct Run {
+    double seconds;
+    std::size_t resumes;
+    SimDuration simulated;
+    std::vector<uint8_t> parts;
+};
+
+static Run drive(std::size_t threads, std::size_t cars, std::size_t laps) {
+    NullLogger null;
+    CompiledCarPolicy policy;
+    Fleet fleet(&null, cars);
+    std::vector<std::unique_ptr<FleetCar> > handles;
+    for (std::size_t i = 0; i < cars; ++i) {
+        handles.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+    }
+    WorkStealingPool pool(threads);
+    ScenarioScheduler scheduler(pool);
+
+    Clock::time_point t0 = Clock::now();
+    for (std::size_t i = 0; i < cars; ++i) {
+        scheduler.spawn(commute(handles[i]->car, (uint32_t)i, laps), SimDuration(i % 1000));
+    }
+    scheduler.run();
+
+    Run out;
+    out.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    out.resumes = scheduler.resumes();
+    out.simulated = scheduler.now();
+    out.parts.insert(out.parts.end(), fleet.engine_active(), fleet.engine_active() + cars);
+    out.parts.insert(out.parts.end(), fleet.target_speed(), fleet.target_speed() + cars);
+    out.parts.insert(out.parts.end(), fleet.gear(), fleet.gear() + cars);
+    out.parts.insert(out.parts.end(), fleet.forward_gear(), fleet.forward_gear() + cars);
+    out.parts.insert(out.parts.end(), fleet.steering_angle(), fleet.steering_angle() + cars);
+    out.parts.insert(out.parts.end(), fleet.brake_force(), fleet.brake_force() + cars);
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::size_t cars = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 200000;
+    std::size_t laps = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 10;
+    std::size_t hardware = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    std::size_t most = hardware < 4 ? 4 : hardware;
+
+    Run reference = drive(1, cars, laps);
+    std::printf("%zu scenarios, %zu laps, %.0f simulated s, %zu hardware threads\n", cars, laps,
+                reference.simulated.count() / 1000.0, hardware);
+    std::printf("%3s threads %12.0f resumes/s\n", "1", reference.resumes / reference.seconds);
+
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 2; threads < most; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(most);
+
+    bool ok = true;
+    for (std::size_t k = 0; k < counts.size(); ++k) {
+        Run run = drive(counts[k], cars, laps);
+        bool same = run.parts == reference.parts && run.resumes == reference.resumes;
+        ok = ok && same;
+        std::printf("%3zu threads %12.0f resumes/s%s%s\n", counts[k], run.resumes / run.seconds,
+                    counts[k] > hardware ? "  (oversubscribed)" : "", same ? "" : "  DIFFERENT");
+    }
+
+    if (!ok) {
+        std::printf("FAILED: results depend on the thread count\n");
+        return 1;
+    }
+    std::printf("identical results for every thread count\n");
+    return 0;
+}
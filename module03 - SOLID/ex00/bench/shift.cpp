@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "shift_schedule.hpp"
+
+// bench/shift [cars]: ShiftSchedule over a fleet in random states (default 2^20
+// cars, 7 in 8 in D), for the default six-speed and a four-speed gearbox.
+//   - every gear chosen by the kernel must match ShiftSchedule::choose (exit 1 otherwise)
+//   - ns per car for the branch-free kernel and for choose() in a loop
+
+typedef std::chrono::steady_clock Clock;
+
+static double ns_per(Clock::time_point t0, std::size_t n) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+}
+
+int main(int argc, char** argv) {
+    std::size_t cars = argc > 1 ? std::strtoul(argv[1], NULL, 10) : (1 << 20);
+    static const float four_speed[] = { 2.8f, 1.6f, 1.0f, 0.7f };
+    static const char* names[] = { "six-speed", "four-speed" };
+    const GearRatios gearboxes[] = { GearRatios(), GearRatios(four_speed, 4, 2.9f, 3.9f) };
+    NullLogger null;
+    bool ok = true;
+
+    for (std::size_t b = 0; b < sizeof(gearboxes) / sizeof(gearboxes[0]); ++b) {
+        const GearRatios& ratios = gearboxes[b];
+        ShiftSchedule schedule(ratios);
+        Fleet fleet(&null, cars, ratios);
+        std::vector<float> speed(cars), throttle(cars);
+        std::srand(42);
+        for (std::size_t i = 0; i < cars; ++i) {
+            bool drive = std::rand() % 8 != 0;
+            fleet.gear()[i] = (uint8_t)(drive ? D : std::rand() % 2 ? R : P);
+            fleet.forward_gear()[i] = (uint8_t)(drive ? 1 + std::rand() % ratios.forward_gears : 0);
+            speed[i] = (float)(std::rand() % 5000) / 100;   // 0 .. 50 m/s
+            throttle[i] = (float)(std::rand() % 101) / 100;
+        }
+        std::vector<uint8_t> start(fleet.forward_gear(), fleet.forward_gear() + cars);
+
+        schedule.step(fleet, speed.data(), throttle.data());
+        for (std::size_t i = 0; i < cars; ++i) {
+            int expected = fleet.gear()[i] == D ? schedule.choose(speed[i], throttle[i], start[i]) : start[i];
+            if (fleet.forward_gear()[i] != expected) {
+                std::printf("%s: MISMATCH at car %zu: %d, choose() says %d\n",
+                            names[b], i, fleet.forward_gear()[i], expected);
+                ok = false;
+                break;
+            }
+        }
+
+        // Each tick starts from the same gears so both sides do the same work.
+        const std::size_t rounds = 20;
+        Clock::time_point t0 = Clock::now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            std::copy(start.begin(), start.end(), fleet.forward_gear());
+            schedule.step(fleet, speed.data(), throttle.data());
+        }
+        double kernel = ns_per(t0, rounds * cars);
+        t0 = Clock::now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            std::copy(start.begin(), start.end(), fleet.forward_gear());
+            uint8_t* forward = fleet.forward_gear();
+            for (std::size_t i = 0; i < cars; ++i) {
+                if (fleet.gear()[i] == D) {
+                    forward[i] = (uint8_t)schedule.choose(speed[i], throttle[i], forward[i]);
+                }
+            }
+        }
+        double scalar = ns_per(t0, rounds * cars);
+        std::printf("%-11s %-26s %7.3f ns/car\n%-11s %-26s %7.3f ns/car\n",
+                    names[b], "ShiftSchedule::schedule", kernel, "", "ShiftSchedule::choose", scalar);
+    }
+
+    if (!ok) {
+        std::printf("FAILED: kernel and choose() disagree\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <chrono>
+#include <cstdio>
+
+#include "car.hpp"
+
+// Same Engine work through the virtual ILogger path and through a sink bound
+// at compile time (BasicEngine<NullLogger>), where logging should vanish.
+
+static const int ITERATIONS = 100000000;
+
+template <typename E>
+static void run(const char* name, E& engine) {
+    volatile int speed = 42;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        engine.accelerate(speed);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / ITERATIONS;
+    std::printf("%-28s %6.2f ns/call\n", name, ns);
+}
+
+int main() {
+    NullLogger null;
+    ILogger* volatile opaque = &null; // hide the dynamic type from the optimizer
+
+    Engine dynamic_engine(opaque);
+    dynamic_engine.start();
+    run("Engine -> ILogger*", dynamic_engine);
+
+    BasicEngine<NullLogger> static_engine(&null);
+    static_engine.start();
+    run("BasicEngine<NullLogger>", static_engine);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "stopping_distance.hpp"
+
+// bench/stopping [cars]: StoppingDistance for random speeds and brake forces
+// (default 2^20 cars), for each brake curve preset.
+//   - table build time
+//   - worst error against simulating each car to a stop with VehicleDynamics
+//     (checked on the first 10000 cars; exit 1 above TOLERANCE)
+//   - ns per prediction: table lookup vs simulation
+
+typedef std::chrono::steady_clock Clock;
+
+static const float TOLERANCE = 0.05f; // m, or 0.1% of the distance if larger
+
+// Runs the cars to a stop, as the table would have to without precomputation.
+static void simulate(const DynamicsParams& params, const std::vector<float>& start,
+                     const std::vector<uint8_t>& force, std::vector<float>& out) {
+    std::size_t n = start.size();
+    std::vector<uint8_t> zero(n, 0), drive(n, D);
+    std::vector<int8_t> straight(n, 0);
+    std::vector<float> speed(start);
+    DynamicsInputs in;
+    in.engine_active = zero.data();
+    in.target_speed = zero.data();
+    in.gear = drive.data();
+    in.brake_force = force.data();
+    in.steering_angle = straight.data();
+    out.assign(n, 0);
+    for (bool moving = true; moving; ) {
+        VehicleDynamics::integrate(params, in, speed.data(), 0, n);
+        moving = false;
+        for (std::size_t i = 0; i < n; ++i) {
+            float v = speed[i] < 0 ? -speed[i] : speed[i];
+            out[i] += v * params.dt;
+            moving = moving || v > 0;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], NULL, 10) : (1 << 20);
+    const std::size_t checked = n < 10000 ? n : 10000;
+    static const char* names[] = { "linear", "progressive", "sharp" };
+    const BrakeCurve curves[] = { BrakeCurve::linear(), BrakeCurve::progressive(), BrakeCurve::sharp() };
+    bool ok = true;
+
+    std::srand(42);
+    std::vector<float> speed(n);
+    std::vector<uint8_t> force(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        speed[i] = (float)(std::rand() % 14000 - 2000) / 200;  // -10 .. 60 m/s
+        force[i] = (uint8_t)(std::rand() % (BrakingSystem::MAX_BRAKE_FORCE + 1));
+    }
+    std::vector<float> predicted(n);
+
+    for (std::size_t c = 0; c < sizeof(curves) / sizeof(curves[0]); ++c) {
+        DynamicsParams params;
+        params.brakes = curves[c];
+
+        Clock::time_point t0 = Clock::now();
+        StoppingDistance* stopping = new StoppingDistance(params);
+        double build = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+        const std::size_t rounds = 20;
+        t0 = Clock::now();
+        for (std::size_t r = 0; r < rounds; ++r) {
+            stopping->distance(speed.data(), force.data(), predicted.data(), n);
+        }
+        double lookup = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / (rounds * n);
+
+        std::vector<float> few_speed(speed.begin(), speed.begin() + checked);
+        std::vector<uint8_t> few_force(force.begin(), force.begin() + checked);
+        std::vector<float> exact;
+        t0 = Clock::now();
+        simulate(params, few_speed, few_force, exact);
+        double simulation = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / checked;
+
+        float worst = 0;
+        for (std::size_t i = 0; i < checked; ++i) {
+            float err = predicted[i] - exact[i];
+            err = err < 0 ? -err : err;
+            float allowed = exact[i] * 0.001f > TOLERANCE ? exact[i] * 0.001f : TOLERANCE;
+            ok = ok && err <= allowed;
+            worst = err > worst ? err : worst;
+        }
+        std::printf("%-12s build %7.2f ms  max error %.4f m  lookup %7.3f ns/car  simulation %9.1f ns/car\n",
+                    names[c], build, worst, lookup, simulation);
+        delete stopping;
+    }
+
+    if (!ok) {
+        std::printf("FAILED: error above tolerance\n");
+        return 1;
+    }
+    return 0;
+}
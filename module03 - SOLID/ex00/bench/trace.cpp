@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "car_actor.hpp"
+#include "car_policy.hpp"
+#include "command_trace.hpp"
+#include "fleet.hpp"
+#include "fleet_simulator.hpp"
+
+// bench/trace [commands] [cars]: random calls (default 2M) on a fleet of
+// FleetCars (default 10k), made directly and then through CarRecorders into
+// a trace in /tmp. The trace is replayed onto fresh fleets at full speed,
+// through a FleetSimulator (one tick) and a CarActorSystem (2 workers), and
+// in real time: all must end in exactly the recorded fleet's state, and the
+// real-time replay must take as long as the recording (within 10%). Prints
+// ns per call for each (exit 1 otherwise).
+
+typedef std::chrono::steady_clock Clock;
+
+static const char* TRACE_PATH = "/tmp/car_bench.trace";
+
+struct Cars {
+    Fleet fleet;
+    std::vector<std::unique_ptr<FleetCar> > handles;
+    std::vector<Car*> cars;
+
+    Cars(ILogger* logger, ICarPolicy& policy, std::size_t count) : fleet(logger, count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            handles.push_back(std::unique_ptr<FleetCar>(new FleetCar(fleet, i, policy)));
+            cars.push_back(&handles[i]->car);
+        }
+    }
+
+    bool same(const Cars& other) const {
+        return same_fleet(fleet, other.fleet);
+    }
+
+    static bool same_fleet(const Fleet& a, const Fleet& b) {
+        std::size_t n = a.size();
+        return std::memcmp(a.engine_active(), b.engine_active(), n) == 0
+            && std::memcmp(a.target_speed(), b.target_speed(), n) == 0
+            && std::memcmp(a.gear(), b.gear(), n) == 0
+            && std::memcmp(a.forward_gear(), b.forward_gear(), n) == 0
+            && std::memcmp(a.steering_angle(), b.steering_angle(), n) == 0
+            && std::memcmp(a.brake_force(), b.brake_force(), n) == 0;
+    }
+};
+
+// The calls a driver makes, on a Car or a CarRecorder alike.
+template <typename C>
+static void drive(C& car, uint32_t r) {
+    switch (r % 12) {
+        case 0: car.start(); break;
+        case 1: car.stop(); break;
+        case 2: case 3: car.shift_gears_up(); break;
+        case 4: car.shift_gears_down(); break;
+        case 5: car.reverse(); break;
+        case 6: car.accelerate((int)(r / 12 % 130)); break;
+        case 7: case 8: car.turn_wheel((int)(r / 12 % 101) - 50); break;
+        case 9: car.straighten_wheels(); break;
+        case 10: car.apply_emergency_brakes(); break;
+        default: car.apply_force_on_brakes((int)(r / 12 % 111)); break;
+    }
+}
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t commands = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2000000;
+    std::size_t count = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 10000;
+    NullLogger null;
+    CompiledCarPolicy policy;
+
+    Cars direct(&null, policy, count);
+    uint32_t seed = 3;
+    Clock::time_point t0 = Clock::now();
+    for (std::size_t i = 0; i < commands; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        drive(*direct.cars[(seed >> 8) % count], seed >> 4);
+    }
+    double plain = since(t0);
+
+    Cars recorded(&null, policy, count);
+    double recording;
+    {
+        TraceWriter trace(TRACE_PATH);
+        std::vector<CarRecorder> recorders;
+        for (std::size_t i = 0; i < count; ++i) {
+            recorders.push_back(CarRecorder(*recorded.cars[i], trace, (uint32_t)i));
+        }
+        seed = 3;
+        t0 = Clock::now();
+        for (std::size_t i = 0; i < commands; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            drive(recorders[(seed >> 8) % count], seed >> 4);
+        }
+        recording = since(t0);
+    }
+
+    TraceReplayer replayer(TRACE_PATH);
+    Cars replayed(&null, policy, count);
+    t0 = Clock::now();
+    uint64_t records = replayer.replay(replayed.cars.data(), count);
+    double fast = since(t0);
+    bool ok = records == commands && recorded.same(direct) && replayed.same(recorded);
+
+    std::printf("%zu calls on %zu cars, trace of %.1f MB\n", commands, count,
+                records * sizeof(TraceRecord) / 1e6);
+    std::printf("direct calls        %6.1f ns/call\n", plain * 1e9 / commands);
+    std::printf("recorded calls      %6.1f ns/call\n", recording * 1e9 / commands);
+    std::printf("replay, full speed  %6.1f ns/call%s\n", fast * 1e9 / commands,
+                ok ? "  (same final state)" : "  DIFFERENT");
+
+    Fleet simulated(&null, count);
+    WorkStealingPool pool(1);
+    FleetSimulator simulator(simulated, policy, pool);
+    t0 = Clock::now();
+    replayer.replay(simulator);
+    simulator.tick();
+    double simulating = since(t0);
+    bool same = Cars::same_fleet(simulated, recorded.fleet);
+    std::printf("replay, simulator   %6.1f ns/call%s\n", simulating * 1e9 / commands,
+                same ? "  (same final state)" : "  DIFFERENT");
+    ok = ok && same;
+
+    Cars acted(&null, policy, count);
+    CarActorSystem actors(2, 1024);
+    for (std::size_t i = 0; i < count; ++i) {
+        actors.spawn(*acted.cars[i]);
+    }
+    actors.start();
+    t0 = Clock::now();
+    replayer.replay(actors);
+    actors.wait_idle();
+    double acting = since(t0);
+    actors.stop();
+    same = acted.same(recorded);
+    std::printf("replay, actors      %6.1f ns/call%s\n", acting * 1e9 / commands,
+                same ? "  (same final state)" : "  DIFFERENT");
+    ok = ok && same;
+
+    // Real time: the whole trace again, which must take as long as the recording did.
+    Cars paced(&null, policy, count);
+    t0 = Clock::now();
+    replayer.replay(paced.cars.data(), count, REPLAY_REAL_TIME);
+    double real_time = since(t0);
+    double span = std::chrono::duration<double>(replayer.duration()).count();
+    bool on_time = real_time >= span && real_time < span * 1.1 + 0.01;
+    ok = ok && paced.same(recorded) && on_time;
+    std::printf("replay, real time   %6.3f s for a trace spanning %.3f s%s\n", real_time, span,
+                on_time ? "" : "  OFF PACE");
+
+    std::remove(TRACE_PATH);
+    if (!ok) {
+        std::printf("FAILED: replay does not reproduce the recording\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "vectorize.hpp"
+
+/*
+BicycleModel: steering angle and speed to yaw rate, heading and position.
+
+Kinematic bicycle model: the car is one steered front wheel and one rear
+wheel on the car's axis, tracked at its centre of mass, `lr` ahead of
+the rear axle (lr = rear_ratio * wheelbase):
+
+    beta      = atan(rear_ratio * tan(delta))         slip angle at the centre of mass
+    yaw_rate  = v * sin(beta) / lr
+    x        += v * cos(heading + beta) * dt
+    y        += v * sin(heading + beta) * dt
+    heading  += yaw_rate * dt                          wrapped to [-pi, pi)
+
+No atan is needed: with s = sin(delta), c = cos(delta) and k = rear_ratio,
+
+    sin(beta) = k s / n      cos(beta) = c / n      n = sqrt(c^2 + k^2 s^2)
+
+and sin / cos(heading + beta) expand into sin / cos of heading and beta.
+All sines and cosines are Taylor polynomials (to degree 11 / 12) on
+[-pi/2, pi/2]; heading is folded into that range first. Their error, under
+1e-8, is below float resolution. With |delta| <= 45 degrees and k <= 1,
+n^2 lies in [0.5, 1], where 1 / n is a linear guess refined by three
+Newton steps (no sqrt: with errno semantics it would not vectorize).
+
+integrate() is the batch kernel over SoA columns: straight-line float
+math, selects only, no table lookups (gathers do not vectorize on plain
+SSE2), built with CAR_VECTORIZE. reference() is the same step for one car
+in double precision with libm; bench/bicycle checks the kernel against it.
+*/
+
+struct BicycleColumns {
+    const float* speed;           // m/s, signed
+    const int8_t* steering_angle; // degrees
+    float* heading;               // rad
+    float* x;                     // m
+    float* y;                     // m
+    float* yaw_rate;              // rad/s, written
+};
+
+class BicycleModel
+{
+    public:
+        BicycleModel(float wheelbase = 2.7f, float rear_ratio = 0.5f)
+            : _wheelbase(wheelbase), _rear_ratio(rear_ratio) {
+            if (!(wheelbase > 0) || !(rear_ratio > 0 && rear_ratio <= 1)) {
+                throw std::runtime_error("Bicycle model needs wheelbase > 0 and 0 < rear_ratio <= 1");
+            }
+        }
+
+        float wheelbase() const { return _wheelbase; }
+        float rear_ratio() const { return _rear_ratio; }
+
+        void step(const BicycleColumns& c, float dt, std::size_t begin, std::size_t end) const {
+            integrate(_wheelbase, _rear_ratio, dt, c, begin, end);
+        }
+
+        // Angles outside +-MAX_TURN_ANGLE are clamped.
+        CAR_VECTORIZE
+        static void integrate(float wheelbase, float rear_ratio, float dt,
+                              const BicycleColumns& c, std::size_t begin, std::size_t end) {
+            const float* __restrict speed = c.speed;
+            const int8_t* __restrict angle = c.steering_angle;
+            float* __restrict heading = c.heading;
+            float* __restrict x = c.x;
+            float* __restrict y = c.y;
+            float* __restrict yaw_rate = c.yaw_rate;
+            const float max = SteeringSystem::MAX_TURN_ANGLE;
+            const float pi = 3.14159265f;
+            const float half_pi = pi / 2;
+            const float two_pi = 2 * pi;
+            const float rad = pi / 180;
+            const float k = rear_ratio;
+            const float inv_lr = 1 / (rear_ratio * wheelbase);
+            const float s3 = -1.0f / 6, s5 = 1.0f / 120, s7 = -1.0f / 5040;
+            const float s9 = 1.0f / 362880, s11 = -1.0f / 39916800;
+            const float c2 = -1.0f / 2, c4 = 1.0f / 24, c6 = -1.0f / 720;
+            const float c8 = 1.0f / 40320, c10 = -1.0f / 3628800, c12 = 1.0f / 479001600;
+
+            // Strips of BLOCK cars: the int8 angle column is turned into sin / cos(beta)
+            // first, so the main loop is float-only (GCC will not vectorize the mix).
+            float sin_beta[BLOCK];
+            float cos_beta[BLOCK];
+            for (std::size_t base = begin; base < end; base += BLOCK) {
+                std::size_t n = end - base < BLOCK ? end - base : BLOCK;
+
+                for (std::size_t j = 0; j < n; ++j) {
+                    float d = angle[base + j];
+                    d = d < -max ? -max : d;
+                    d = d > max ? max : d;
+                    d *= rad;
+                    float d2 = d * d;
+                    float sin_d = d * (1 + d2 * (s3 + d2 * (s5 + d2 * (s7 + d2 * (s9 + d2 * s11)))));
+                    float cos_d = 1 + d2 * (c2 + d2 * (c4 + d2 * (c6 + d2 * (c8 + d2 * (c10 + d2 * c12)))));
+                    float ks = k * sin_d;
+                    float n2 = cos_d * cos_d + ks * ks;
+                    float inv_norm = 1.78f - 0.8f * n2;
+                    inv_norm *= 1.5f - 0.5f * n2 * inv_norm * inv_norm;
+                    inv_norm *= 1.5f - 0.5f * n2 * inv_norm * inv_norm;
+                    inv_norm *= 1.5f - 0.5f * n2 * inv_norm * inv_norm;
+                    sin_beta[j] = ks * inv_norm;
+                    cos_beta[j] = cos_d * inv_norm;
+                }
+
+                for (std::size_t j = 0; j < n; ++j) {
+                    std::size_t i = base + j;
+                    // heading folded into [-pi/2, pi/2]: sin keeps its value, cos flips sign
+                    float h = heading[i];
+                    float f = h > half_pi ? pi - h : h;
+                    f = f < -half_pi ? -pi - f : f;
+                    float sign = f == h ? 1.0f : -1.0f;
+                    float f2 = f * f;
+                    float sin_h = f * (1 + f2 * (s3 + f2 * (s5 + f2 * (s7 + f2 * (s9 + f2 * s11)))));
+                    float cos_h = sign * (1 + f2 * (c2 + f2 * (c4 + f2 * (c6 + f2 * (c8 + f2 * (c10 + f2 * c12))))));
+
+                    float v = speed[i];
+                    float sin_b = sin_beta[j];
+                    float cos_b = cos_beta[j];
+                    float r = v * sin_b * inv_lr;
+                    x[i] += v * (cos_h * cos_b - sin_h * sin_b) * dt;
+                    y[i] += v * (sin_h * cos_b + cos_h * sin_b) * dt;
+                    yaw_rate[i] = r;
+                    h += r * dt;
+                    h -= (float)(h >= pi) * two_pi;
+                    h += (float)(h < -pi) * two_pi;
+                    heading[i] = h;
+                }
+            }
+        }
+
+        // One car, double precision, libm trig: what integrate() approximates.
+        void reference(double speed, int angle, double dt,
+                       double& heading, double& x, double& y, double& yaw_rate) const {
+            const double pi = 3.14159265358979323846;
+            const int max = SteeringSystem::MAX_TURN_ANGLE;
+            double delta = (angle < -max ? -max : angle > max ? max : angle) * pi / 180;
+            double beta = std::atan(_rear_ratio * std::tan(delta));
+            yaw_rate = speed * std::sin(beta) / (_rear_ratio * _wheelbase);
+            x += speed * std::cos(heading + beta) * dt;
+            y += speed * std::sin(heading + beta) * dt;
+            heading += yaw_rate * dt;
+            heading = heading >= pi ? heading - 2 * pi : heading < -pi ? heading + 2 * pi : heading;
+        }
+
+    private:
+        static const std::size_t BLOCK = 256;
+
+        float _wheelbase;
+        float _rear_ratio;
+};
+const std::size_t BicycleModel::BLOCK;
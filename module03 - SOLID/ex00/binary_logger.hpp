@@ -0,0 +1,61 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+#include "car.hpp"
+#include "record_file.hpp"
+
+/*
+BinaryLogger: stores component events as fixed 24-byte LogRecords.
+
+File layout: a record file (record_file.hpp) of raw LogRecords. Nothing
+is formatted at log time; `logdecode <file>` renders the records back into
+the usual colored text lines. A failed write throws from record() or
+flush(), and keeps throwing: a log that ends early is never mistaken for
+a complete one.
+
+Free-form text (log()/write(), e.g. the banners in main.cpp) has no record
+form; it is forwarded to the optional text sink or discarded.
+*/
+
+static const char BINARY_LOG_MAGIC[8] = { 'C', 'A', 'R', 'L', 'O', 'G', '\0', '\0' };
+static const uint32_t BINARY_LOG_VERSION = 1;
+
+class BinaryLogger : public ILogger
+{
+    public:
+        BinaryLogger(const std::string& path, ILogger* text_sink = NULL)
+            : _file(path, BINARY_LOG_MAGIC, BINARY_LOG_VERSION, sizeof(LogRecord), "binary log"),
+              _text_sink(text_sink) {}
+
+        void log(const std::string &message) const {
+            if (_text_sink) {
+                _text_sink->log(message);
+            }
+        }
+
+        void write(const char* data, std::size_t len) const {
+            if (_text_sink) {
+                _text_sink->write(data, len);
+            }
+        }
+
+        void record(const LogRecord& r) const {
+            LogRecord stamped = r;
+            stamped.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            _file.append(&stamped, sizeof(stamped));
+        }
+
+        void flush() const {
+            _file.flush();
+        }
+
+    private:
+        mutable RecordFileWriter _file;
+        ILogger* _text_sink;
+
+    private:
+        BinaryLogger(const BinaryLogger&);
+        BinaryLogger& operator=(const BinaryLogger&);
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+BoundedQueue<T>: fixed-capacity lock-free queue, any number of producers
+and consumers.
+
+One sequence number per slot tells a producer the slot is free and a
+consumer it is filled, and the enqueue / dequeue positions are claimed
+with one CAS each. Neither side ever takes a lock; push() on a full queue
+and pop() on an empty one return false. Capacity is rounded up to a power
+of two.
+
+push_with(fill) / pop_with(consume) hand the claimed slot's value to a
+callback instead of copying it, so a slot's storage (a string's capacity,
+say) is reused from one round to the next. AsyncLogger's ring and
+CarActorSystem's mailboxes are both BoundedQueues.
+*/
+
+template <typename T>
+class BoundedQueue
+{
+    public:
+        BoundedQueue(std::size_t capacity)
+            : _mask(_round_up_pow2(capacity) - 1), _slots(_mask + 1) {
+            for (std::size_t i = 0; i <= _mask; ++i) {
+                _slots[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t capacity() const { return _mask + 1; }
+
+        bool push(const T& value) {
+            return push_with(Assign(value));
+        }
+
+        bool pop(T& value) {
+            return pop_with(Take(value));
+        }
+
+        // Claims a free slot and calls fill(T&) on its value before publishing it.
+        template <typename Fill>
+        bool push_with(Fill fill) {
+            std::size_t pos = _enqueue.pos.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = _slots[pos & _mask];
+                std::size_t seq = slot.seq.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+                if (diff == 0) {
+                    if (_enqueue.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst)) {
+                        fill(slot.value);
+                        slot.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false; // full
+                } else {
+                    pos = _enqueue.pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Claims the oldest filled slot and calls consume(T&) on its value before freeing it.
+        template <typename Consume>
+        bool pop_with(Consume consume) {
+            std::size_t pos = _dequeue.pos.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = _slots[pos & _mask];
+                std::size_t seq = slot.seq.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+                if (diff == 0) {
+                    if (_dequeue.pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        consume(slot.value);
+                        slot.seq.store(pos + _mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false; // empty
+                } else {
+                    pos = _dequeue.pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Positions claimed so far by pushes and by pops; the pop at position p
+        // takes the value of the push at p.
+        std::size_t enqueued() const { return _enqueue.pos.load(std::memory_order_seq_cst); }
+        std::size_t dequeued() const { return _dequeue.pos.load(std::memory_order_seq_cst); }
+
+        // True once a push has claimed a slot, even if it has not finished writing it.
+        bool claimed() const {
+            return _enqueue.pos.load(std::memory_order_seq_cst) != _dequeue.pos.load(std::memory_order_seq_cst);
+        }
+
+    private:
+        struct Assign {
+            const T& value;
+            Assign(const T& value) : value(value) {}
+            void operator()(T& slot) const { slot = value; }
+        };
+
+        struct Take {
+            T& value;
+            Take(T& value) : value(value) {}
+            void operator()(T& slot) const { value = slot; }
+        };
+
+        struct Slot {
+            std::atomic<std::size_t> seq;
+            T value;
+            Slot() : seq(0), value() {}
+        };
+
+        // Producers and consumers write positions on different cache lines.
+        struct Position {
+            char pad[64];
+            std::atomic<std::size_t> pos;
+            Position() : pos(0) {}
+        };
+
+        std::size_t _mask;
+        std::vector<Slot> _slots;
+        Position _enqueue;
+        Position _dequeue;
+
+    private:
+        BoundedQueue(const BoundedQueue&);
+        BoundedQueue& operator=(const BoundedQueue&);
+
+        static std::size_t _round_up_pow2(std::size_t n) {
+            std::size_t p = 2;
+            while (p < n) {
+                p <<= 1;
+            }
+            return p;
+        }
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdexcept>
+
+#include "car.hpp"
+
+/*
+BrakeCurve: brake force (0 .. MAX_BRAKE_FORCE) to deceleration.
+
+    t     = force / MAX_BRAKE_FORCE
+    decel = max_decel * (c1 t + c2 t^2 + c3 t^3)      c1 + c2 + c3 = 1
+
+A cubic keeps the curve cheap inside the vectorized dynamics loop (no
+table, so no gather) while covering the usual pedal maps; the presets
+below are a straight line, a progressive pedal (soft first half, strong
+end) and a sharp one (most of the bite early). Any other shape: pass the
+coefficients, the curve only has to rise from 0 to max_decel.
+*/
+
+struct BrakeCurve {
+    float max_decel;  // m/s^2 at MAX_BRAKE_FORCE
+    float c1, c2, c3;
+
+    BrakeCurve(float max_decel = 8.0f, float c1 = 1, float c2 = 0, float c3 = 0)
+        : max_decel(max_decel), c1(c1), c2(c2), c3(c3) {
+        float top = c1 + c2 + c3;
+        if (!(max_decel > 0) || top < 0.999f || top > 1.001f) {
+            throw std::runtime_error("Brake curve must reach max_decel at full force");
+        }
+        for (int f = 1; f <= BrakingSystem::MAX_BRAKE_FORCE; ++f) {
+            if (decel(f) < decel(f - 1)) {
+                throw std::runtime_error("Brake curve must not fall as force rises");
+            }
+        }
+    }
+
+    static BrakeCurve linear(float max_decel = 8.0f) { return BrakeCurve(max_decel, 1, 0, 0); }
+    static BrakeCurve progressive(float max_decel = 8.0f) { return BrakeCurve(max_decel, 0.2f, 0.3f, 0.5f); }
+    static BrakeCurve sharp(float max_decel = 8.0f) { return BrakeCurve(max_decel, 1.8f, -0.8f, 0); }
+
+    float decel(int force) const {
+        float t = (float)force / BrakingSystem::MAX_BRAKE_FORCE;
+        return max_decel * t * (c1 + t * (c2 + t * c3));
+    }
+};
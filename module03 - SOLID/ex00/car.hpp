@@ -1,5 +1,15 @@
 #pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+
+#include "log_event.hpp"
 
 // start(): starts the engine
 // stop(): stops the engine and applies the brakes
@@ -34,50 +44,174 @@ By the duck typing philosophy, we can say that a `Car` is a collection of parts
 */
 
 namespace ansi {
-    static const char* RESET = "\033[0m";
-    static const char* RED   = "\033[31m";
-    static const char* GREEN = "\033[32m";
-    static const char* YEL   = "\033[33m";
-    static const char* BLUE  = "\033[34m";
-    static const char* MAG   = "\033[35m";
-    static const char* CYN   = "\033[36m";
-    static const char* WHT   = "\033[37m";
+    static const char* const RESET = "\033[0m";
+    static const char* const RED   = "\033[31m";
+    static const char* const GREEN = "\033[32m";
+    static const char* const YEL   = "\033[33m";
+    static const char* const BLUE  = "\033[34m";
+    static const char* const MAG   = "\033[35m";
+    static const char* const CYN   = "\033[36m";
+    static const char* const WHT   = "\033[37m";
 }
 
 template <typename T> struct LogColor {
     static const char* color() {
         return ansi::RESET; // Default color
     }
+    static ComponentId id() {
+        return COMPONENT_UNKNOWN;
+    }
 };
 
 template <> struct LogColor<class Engine> {
     static const char* color() {
         return ansi::YEL; // Yellow for Engine
     }
+    static ComponentId id() {
+        return COMPONENT_ENGINE;
+    }
 };
 
 template <> struct LogColor<class Transmission> {
     static const char* color() {
         return ansi::CYN; // Cyan for Transmission
     }
+    static ComponentId id() {
+        return COMPONENT_TRANSMISSION;
+    }
 };
 
 template <> struct LogColor<class SteeringSystem> {
     static const char* color() {
         return ansi::GREEN; // Green for SteeringSystem
     }
+    static ComponentId id() {
+        return COMPONENT_STEERING;
+    }
 };
 
 template <> struct LogColor<class BrakingSystem> {
     static const char* color() {
         return ansi::RED; // Red for BrakingSystem
     }
+    static ComponentId id() {
+        return COMPONENT_BRAKING;
+    }
+};
+
+template <> struct LogColor<class Car> {
+    static const char* color() {
+        return ansi::RESET; // Car keeps the terminal's default color
+    }
+    static ComponentId id() {
+        return COMPONENT_CAR;
+    }
+};
+
+// Build with -DLOG_MIN_LEVEL=LOG_INFO (see `make quiet`) to compile trace/debug calls out.
+#ifndef LOG_MIN_LEVEL
+# define LOG_MIN_LEVEL LOG_TRACE
+#endif
+
+#ifndef LOG_BUFFER_SIZE
+# define LOG_BUFFER_SIZE 256 // lines shorter than this are formatted without touching the heap
+#endif
+
+/*
+LogBuffer: a per-thread, fixed-size line buffer used by LoggerMixin::log.
+
+Pieces (C strings, std::string, integers) are appended in place; only a line
+longer than LOG_BUFFER_SIZE spills into a std::string, whose capacity is kept
+for the next long line.
+*/
+class LogBuffer
+{
+    public:
+        static LogBuffer& local() {
+            static thread_local LogBuffer buffer;
+            return buffer;
+        }
+
+        void clear() {
+            _len = 0;
+            _spilled = false;
+        }
+
+        const char* data() const { return _spilled ? _spill.data() : _data; }
+        std::size_t size() const { return _spilled ? _spill.size() : _len; }
+
+        LogBuffer& append(const char* s, std::size_t n) {
+            if (_spilled) {
+                _spill.append(s, n);
+            } else if (_len + n <= sizeof(_data)) {
+                std::memcpy(_data + _len, s, n);
+                _len += n;
+            } else {
+                _spill.assign(_data, _len);
+                _spill.append(s, n);
+                _spilled = true;
+            }
+            return *this;
+        }
+
+        LogBuffer& operator<<(const char* s) { return append(s, std::strlen(s)); }
+        LogBuffer& operator<<(const std::string& s) { return append(s.data(), s.size()); }
+        LogBuffer& operator<<(char c) { return append(&c, 1); }
+        LogBuffer& operator<<(int v) { return _signed(v); }
+        LogBuffer& operator<<(long v) { return _signed(v); }
+        LogBuffer& operator<<(long long v) { return _signed(v); }
+        LogBuffer& operator<<(unsigned v) { return _unsigned(v); }
+        LogBuffer& operator<<(unsigned long v) { return _unsigned(v); }
+        LogBuffer& operator<<(unsigned long long v) { return _unsigned(v); }
+
+    private:
+        char _data[LOG_BUFFER_SIZE];
+        std::size_t _len;
+        bool _spilled;
+        std::string _spill;
+
+    private:
+        LogBuffer() : _len(0), _spilled(false) {}
+        LogBuffer(const LogBuffer&);
+        LogBuffer& operator=(const LogBuffer&);
+
+        LogBuffer& _signed(long long v) {
+            if (v < 0) {
+                append("-", 1);
+                return _unsigned(0ULL - (unsigned long long)v);
+            }
+            return _unsigned((unsigned long long)v);
+        }
+
+        LogBuffer& _unsigned(unsigned long long v) {
+            char digits[20];
+            std::size_t i = sizeof(digits);
+            do {
+                digits[--i] = (char)('0' + v % 10);
+                v /= 10;
+            } while (v);
+            return append(digits + i, sizeof(digits) - i);
+        }
 };
 
+// Text rendering of a LogRecord, defined once every component is known (end of file).
+inline void render_record(LogBuffer& line, const LogRecord& r);
+
 class ILogger
 {
     public:
         virtual void log(const std::string &message) const = 0;
+        // Raw line entry point; sinks that can consume bytes directly should override it.
+        virtual void write(const char* data, std::size_t len) const {
+            log(std::string(data, len));
+        }
+        // Structured entry point; text sinks get the rendered line through write().
+        virtual void record(const LogRecord& r) const {
+            LogBuffer& line = LogBuffer::local();
+            line.clear();
+            render_record(line, r);
+            write(line.data(), line.size());
+        }
         virtual ~ILogger() {}
 };
 
@@ -87,30 +221,304 @@ class ConsoleLogger : public ILogger
         void log(const std::string &message) const {
             std::cout << message << std::endl;
         }
+        void write(const char* data, std::size_t len) const {
+            std::cout.write(data, len) << std::endl;
+        }
+};
+
+class NullLogger : public ILogger
+{
+    public:
+        void log(const std::string &) const {}
+        void write(const char*, std::size_t) const {}
+        void record(const LogRecord&) const {}
+};
+
+/*
+Per-component rate limiting, keyed like LogColor<T>:
+
+    LogRate<Engine>::config().sample_every = 1000; // keep 1 in 1000 Engine events
+    LogRate<Car>::config().per_second = 50;        // token bucket, burst = per_second
+
+Events at or above exempt_from (warnings, errors) always pass. Suppressed
+events are counted per component instance and reported as one
+"suppressed N messages" line at most every summary_every.
+
+There is no timer: the summary goes out with the first event the component
+logs once summary_every has passed, so after a burst it waits for the next
+event. flush_suppressed() reports it right away (e.g. at the end of a run).
+A config that limits nothing, and a NullLogger sink, skip the limiter
+altogether; the limiter reads the clock only once something is limited.
+*/
+struct LogRateConfig {
+    unsigned long sample_every; // 1 = keep every event
+    double per_second;          // 0 = no token bucket
+    double burst;               // bucket size, defaults to per_second
+    LogLevel exempt_from;
+    std::chrono::milliseconds summary_every;
+
+    bool limits() const { return sample_every > 1 || per_second > 0; }
+};
+
+template <typename T> struct LogRate {
+    static LogRateConfig& config() {
+        static LogRateConfig c = { 1, 0, 0, LOG_WARN, std::chrono::milliseconds(1000) };
+        return c;
+    }
+};
+
+class RateLimiter
+{
+    public:
+        RateLimiter() : _seen(0), _suppressed(0), _tokens(-1) {}
+
+        // false if the event must be dropped (it is then counted as suppressed).
+        bool allow(const LogRateConfig& c, LogLevel level) {
+            if (level >= c.exempt_from || !c.limits()) {
+                return true;
+            }
+            bool keep = c.sample_every <= 1 || _seen++ % c.sample_every == 0;
+            if (keep && c.per_second > 0) {
+                keep = _take_token(c);
+            }
+            if (!keep && _suppressed++ == 0) {
+                _window = clock::now(); // the summary is due summary_every after the first suppression
+            }
+            return keep;
+        }
+
+        // Suppressed count to report now, or 0 while the summary is not due.
+        unsigned long take_summary(const LogRateConfig& c) {
+            if (_suppressed == 0 || clock::now() - _window < c.summary_every) {
+                return 0;
+            }
+            return take_suppressed();
+        }
+
+        // Suppressed count, due or not.
+        unsigned long take_suppressed() {
+            unsigned long n = _suppressed;
+            _suppressed = 0;
+            return n;
+        }
+
+        unsigned long suppressed() const { return _suppressed; }
+
+    private:
+        typedef std::chrono::steady_clock clock;
+
+        unsigned long _seen;
+        unsigned long _suppressed;
+        double _tokens;
+        clock::time_point _refilled;
+        clock::time_point _window;
+
+    private:
+        bool _take_token(const LogRateConfig& c) {
+            double burst = c.burst >= 1 ? c.burst : (c.per_second >= 1 ? c.per_second : 1);
+            clock::time_point now = clock::now();
+            if (_tokens < 0) {
+                _tokens = burst;
+            } else {
+                _tokens += std::chrono::duration<double>(now - _refilled).count() * c.per_second;
+                if (_tokens > burst) {
+                    _tokens = burst;
+                }
+            }
+            _refilled = now;
+            if (_tokens < 1) {
+                return false;
+            }
+            _tokens -= 1;
+            return true;
+        }
 };
 
-template <typename Derived>
+/*
+How LoggerMixin reaches its sink. Through ILogger it is a virtual call; for a
+concrete Sink type the call is qualified, so it can be inlined and, for
+NullLogger, disappear completely.
+*/
+template <typename Sink> struct SinkDispatch {
+    static void write(const Sink& sink, const char* data, std::size_t len) { sink.Sink::write(data, len); }
+    static void record(const Sink& sink, const LogRecord& r) { sink.Sink::record(r); }
+};
+
+template <> struct SinkDispatch<ILogger> {
+    static void write(const ILogger& sink, const char* data, std::size_t len) { sink.write(data, len); }
+    static void record(const ILogger& sink, const LogRecord& r) { sink.record(r); }
+};
+
+/*
+ComponentLog: the way from a catalogued event to the sink, for LoggerMixin
+and for parts that log without one (fleet.hpp): the compile-time level
+filter, then the LogRate<Derived> limiter passed in, then one LogRecord.
+*/
+template <typename Derived, typename Sink = ILogger, LogLevel MinLevel = LOG_MIN_LEVEL>
+struct ComponentLog {
+    template <LogEvent E, typename... Args>
+    static void emit(const Sink* sink, RateLimiter& rate, Args... args) {
+        static_assert(sizeof...(Args) == EventTraits<E>::arity, "payload does not match the event catalogue");
+        if (EventTraits<E>::level < MinLevel || std::is_same<Sink, NullLogger>::value
+            || !admit(sink, rate, EventTraits<E>::level)) {
+            return;
+        }
+        const int32_t payload[] = { (int32_t)args..., 0, 0 };
+        record(sink, E, payload);
+    }
+
+    // A NullLogger discards everything anyway; a config that limits nothing costs one test.
+    static bool admit(const Sink* sink, RateLimiter& rate, LogLevel level) {
+        if (std::is_same<Sink, NullLogger>::value) {
+            return true;
+        }
+        const LogRateConfig& c = LogRate<Derived>::config();
+        if (!c.limits()) {
+            return true;
+        }
+        bool keep = rate.allow(c, level);
+        report(sink, rate.take_summary(c));
+        return keep;
+    }
+
+    static void report(const Sink* sink, unsigned long suppressed) {
+        if (suppressed) {
+            const int32_t payload[] = { suppressed > 0x7fffffffUL ? 0x7fffffff : (int32_t)suppressed, 0 };
+            record(sink, EV_LOG_SUPPRESSED, payload);
+        }
+    }
+
+    static void record(const Sink* sink, LogEvent ev, const int32_t* payload) {
+        if (!sink) {
+            std::cerr << "Logger is not set!" << std::endl;
+            return;
+        }
+        LogRecord r;
+        r.timestamp_ns = 0;
+        r.component = (uint16_t)LogColor<Derived>::id();
+        r.event = (uint16_t)ev;
+        r.args[0] = payload[0];
+        r.args[1] = payload[1];
+        r.args[2] = 0;
+        SinkDispatch<Sink>::record(*sink, r);
+    }
+};
+
+// LoggerMixin<Engine> logs through any ILogger; LoggerMixin<Engine, NullLogger> is bound at compile time.
+template <typename Derived, typename Sink = ILogger, LogLevel MinLevel = LOG_MIN_LEVEL>
 class LoggerMixin : public ILogger
 {
     public:
+        // Levels below MinLevel are a compile-time constant `return`: no formatting, no virtual call.
+        template <LogLevel Level, typename... Args>
+        void log_at(const Args&... args) const {
+            if (Level < MinLevel || !Log::admit(_logger, _rate, Level)) {
+                return;
+            }
+            log(args...);
+        }
+
+        template <typename... Args> void trace(const Args&... args) const { log_at<LOG_TRACE>(args...); }
+        template <typename... Args> void debug(const Args&... args) const { log_at<LOG_DEBUG>(args...); }
+        template <typename... Args> void info(const Args&... args) const { log_at<LOG_INFO>(args...); }
+        template <typename... Args> void warn(const Args&... args) const { log_at<LOG_WARN>(args...); }
+        template <typename... Args> void error(const Args&... args) const { log_at<LOG_ERROR>(args...); }
+
+        // Catalogued component event, e.g. emit<EV_GEAR_CHANGED>(gear); level and text live in log_event.hpp.
+        template <LogEvent E, typename... Args>
+        void emit(Args... args) const {
+            Log::template emit<E>(_logger, _rate, args...);
+        }
+
         void log(const std::string& m) const {
+            log<std::string>(m);
+        }
+
+        // Reports events suppressed since the last summary now rather than with the next event.
+        void flush_suppressed() const {
+            Log::report(_logger, _rate.take_suppressed());
+        }
+
+        // log("Accelerating to ", speed, " km/h.") formats straight into the per-thread LogBuffer.
+        template <typename... Args>
+        void log(const Args&... args) const {
             if (_logger) {
-                std::string class_name = Derived::class_name;
-                std::string color = LogColor<Derived>::color();
-                _logger->log(color + class_name + ": " + m + ansi::RESET);
+                LogBuffer& line = LogBuffer::local();
+                line.clear();
+                line << LogColor<Derived>::color() << Derived::class_name << ": ";
+                _append(line, args...);
+                line << ansi::RESET;
+                SinkDispatch<Sink>::write(*_logger, line.data(), line.size());
             } else {
                 std::cerr << "Logger is not set!" << std::endl;
             }
         }
     protected:
-        ILogger* _logger;
+        Sink* _logger;
+        mutable RateLimiter _rate;
 
     protected:
-        LoggerMixin(ILogger* logger) : _logger(logger) {
+        LoggerMixin(Sink* logger) : _logger(logger) {
             if (!_logger) {
                 throw std::runtime_error("Logger cannot be null");
             }
         }
+
+    private:
+        typedef ComponentLog<Derived, Sink, MinLevel> Log;
+
+        static void _append(LogBuffer&) {}
+
+        template <typename T, typename... Rest>
+        static void _append(LogBuffer& line, const T& first, const Rest&... rest) {
+            line << first;
+            _append(line, rest...);
+        }
+};
+
+/*
+State journal hook. The parts' state, field by field, and where a part
+reports a change to it: nothing unless a journal is attached, so a part
+without one only pays a null test per change (see state_journal.hpp).
+*/
+enum StateField {
+    FIELD_ENGINE_ACTIVE,    // 0 / 1
+    FIELD_TARGET_SPEED,     // km/h
+    FIELD_GEAR,             // Gear
+    FIELD_FORWARD_GEAR,     // 1 .. forward gears in D, 0 otherwise
+    FIELD_STEERING_ANGLE,   // degrees
+    FIELD_BRAKE_FORCE,
+    FIELD_COUNT
+};
+
+class IStateJournal
+{
+    public:
+        virtual void append(uint32_t car, StateField field, int value) = 0;
+        virtual ~IStateJournal() {}
+};
+
+// Base of the standalone parts: journal_to() reports their changes as those of car `car`.
+class StateRecorder
+{
+    public:
+        StateRecorder() : _journal(NULL), _car(0) {}
+
+        void journal_to(IStateJournal* journal, uint32_t car) {
+            _journal = journal;
+            _car = car;
+        }
+
+    protected:
+        void record_state(StateField field, int value) const {
+            if (_journal) {
+                _journal->append(_car, field, value);
+            }
+        }
+
+    private:
+        IStateJournal* _journal;
+        uint32_t _car;
 };
 
 class IEngine
@@ -123,105 +531,322 @@ class IEngine
         virtual ~IEngine() {}
 };
 
-class Engine : public IEngine, public LoggerMixin<Engine>
-{
-    public:
-        static const std::string class_name;
+/*
+Where a part keeps its state and sends its events is up to its State base;
+BasicEngine & co. hold the logic (checks, change detection, events) once:
+
+    EngineState<Sink> & co.     in the part itself, logging through a
+                                LoggerMixin and journaled through a
+                                StateRecorder (Engine, BasicEngine<NullLogger>)
+    FleetEngineState & co.      a car's row of a Fleet's columns (fleet.hpp)
 
-        Engine(ILogger* logger) : LoggerMixin<Engine>(logger), _is_active(false) {
-            log("Initialized.");
+A State provides emit<E>(), record_state() and plain loads / stores of the
+part's fields. A part with its own state logs its initialization; a view
+onto state kept elsewhere does not.
+*/
+template <typename Sink>
+class EngineState : public LoggerMixin<Engine, Sink>, public StateRecorder
+{
+    protected:
+        EngineState(Sink* logger) : LoggerMixin<Engine, Sink>(logger), _is_active(false), _target_speed(0) {
+            this->template emit<EV_ENGINE_INITIALIZED>();
         }
 
+        bool active() const { return _is_active; }
+        int target_speed() const { return _target_speed; }
+        void store_active(bool active) { _is_active = active; }
+        void store_target_speed(int speed) { _target_speed = speed; }
+
+    private:
+        bool _is_active;
+        int _target_speed;
+};
+
+// BasicEngine<Sink> logs straight into a concrete Sink (see LoggerMixin); Engine is the ILogger one.
+template <typename Sink, typename State = EngineState<Sink> >
+class BasicEngine : public IEngine, public State
+{
+    public:
+        template <typename... Args>
+        explicit BasicEngine(Args&&... args) : State(std::forward<Args>(args)...) {}
+
         void start() {
-            log("Started.");
-            _is_active = true;
+            this->template emit<EV_ENGINE_STARTED>();
+            _set_active(true);
         }
         void stop() {
-            log("Stopped.");
-            _is_active = false;
+            this->template emit<EV_ENGINE_STOPPED>();
+            _set_active(false);
+            _set_target_speed(0);
         }
         void accelerate(int speed) {
-            if (!_is_active) {
-                log("Cannot accelerate. Engine is not running.");
+            if (!this->active()) {
+                this->template emit<EV_ENGINE_NOT_RUNNING>();
                 return;
             }
-            log("Accelerating to " + std::to_string(speed) + " km/h.");
+            this->template emit<EV_ENGINE_ACCELERATING>(speed);
+            _set_target_speed(speed < 0 ? 0 : speed > MAX_TARGET_SPEED ? MAX_TARGET_SPEED : speed);
         }
 
         bool is_active() const {
-            return _is_active;
+            return this->active();
+        }
+
+        // km/h the throttle drives towards (see dynamics.hpp); 0 when stopped.
+        int get_target_speed() const {
+            return this->target_speed();
         }
-    
+
+        static const int MAX_TARGET_SPEED = 255;
+
     private:
-        bool _is_active;
+        void _set_active(bool active) {
+            if (active != this->active()) {
+                this->store_active(active);
+                this->record_state(FIELD_ENGINE_ACTIVE, active);
+            }
+        }
+
+        void _set_target_speed(int speed) {
+            if (speed != this->target_speed()) {
+                this->store_target_speed(speed);
+                this->record_state(FIELD_TARGET_SPEED, speed);
+            }
+        }
+};
+
+class Engine : public BasicEngine<ILogger>
+{
+    public:
+        static const std::string class_name;
+
+        Engine(ILogger* logger)
+            : BasicEngine<ILogger>(logger) {}
 };
 const std::string Engine::class_name = "Engine";
+template <typename Sink, typename State> const int BasicEngine<Sink, State>::MAX_TARGET_SPEED;
 
 
-enum Gear { P, D, R };
+enum Gear { P, D, R, N, GEAR_COUNT };
 
-inline const std::string gear_to_string(Gear g)
+inline const char* gear_to_string(Gear g)
 {
     switch (g) { case P: return "P";
                  case D: return "D";
                  case R: return "R";
+                 case N: return "N";
                  default: return "?"; }
 }
 
+/*
+Gear ratios: forward gears 1 .. forward_gears, shortest first and each
+longer than the one before, plus reverse and the final drive. The default
+is a common six-speed automatic.
+*/
+struct GearRatios {
+    static const int MAX_FORWARD_GEARS = 8;
+
+    int forward_gears;
+    float forward[MAX_FORWARD_GEARS];
+    float reverse;
+    float final_drive;
+
+    GearRatios() : forward_gears(6), reverse(3.2f), final_drive(3.7f) {
+        static const float six_speed[] = { 3.6f, 2.2f, 1.5f, 1.1f, 0.9f, 0.75f };
+        for (int g = 0; g < MAX_FORWARD_GEARS; ++g) {
+            forward[g] = g < forward_gears ? six_speed[g] : 0;
+        }
+    }
+
+    GearRatios(const float* ratios, int count, float reverse, float final_drive)
+        : forward_gears(count), reverse(reverse), final_drive(final_drive) {
+        if (count < 1 || count > MAX_FORWARD_GEARS) {
+            throw std::runtime_error("Forward gear count must be between 1 and 8");
+        }
+        if (!(reverse > 0) || !(final_drive > 0)) {
+            throw std::runtime_error("Reverse and final drive ratios must be positive");
+        }
+        for (int g = 0; g < MAX_FORWARD_GEARS; ++g) {
+            forward[g] = g < count ? ratios[g] : 0;
+            if (g < count && (!(ratios[g] > 0) || (g > 0 && !(ratios[g] < ratios[g - 1])))) {
+                throw std::runtime_error("Forward ratios must be positive and falling");
+            }
+        }
+    }
+
+    // Engine turns per wheel turn in forward gear `gear` (1 .. forward_gears).
+    float overall(int gear) const {
+        return forward[gear - 1] * final_drive;
+    }
+};
+const int GearRatios::MAX_FORWARD_GEARS;
+
+enum ShiftRequest { SHIFT_PARK, SHIFT_REVERSE, SHIFT_NEUTRAL, SHIFT_DRIVE, SHIFT_UP, SHIFT_DOWN, SHIFT_REQUEST_COUNT };
+
+/*
+Transmission state machine. The state is the selector (a Gear) and the
+forward gear: 1 .. forward_gears in D, 0 anywhere else. For each selector
+and request, GEAR_TRANSITIONS gives the next selector and what becomes of
+the forward gear:
+
+    NONE    0, the selector is not D        FIRST   1, entering D
+    KEEP    unchanged                       UP / DOWN   one gear; refused past
+    REFUSE  the request means nothing here              the top or below first
+
+Up and down step through the forward gears in D; up from P, R or N
+engages D in first gear, down from first gear stays there. A request that
+leaves the state as it was is refused as well.
+*/
+enum GearStep { GEAR_REFUSE, GEAR_NONE, GEAR_KEEP, GEAR_FIRST, GEAR_UP, GEAR_DOWN };
+
+struct GearTransition {
+    uint8_t selector; // Gear
+    uint8_t step;     // GearStep
+};
+
+static const GearTransition GEAR_TRANSITIONS[GEAR_COUNT][SHIFT_REQUEST_COUNT] = {
+    //           PARK               REVERSE            NEUTRAL            DRIVE               UP                 DOWN
+    /* P */ { { P, GEAR_NONE }, { R, GEAR_NONE }, { N, GEAR_NONE }, { D, GEAR_FIRST }, { D, GEAR_FIRST }, { P, GEAR_REFUSE } },
+    /* D */ { { P, GEAR_NONE }, { R, GEAR_NONE }, { N, GEAR_NONE }, { D, GEAR_KEEP },  { D, GEAR_UP },    { D, GEAR_DOWN } },
+    /* R */ { { P, GEAR_NONE }, { R, GEAR_NONE }, { N, GEAR_NONE }, { D, GEAR_FIRST }, { D, GEAR_FIRST }, { R, GEAR_REFUSE } },
+    /* N */ { { P, GEAR_NONE }, { R, GEAR_NONE }, { N, GEAR_NONE }, { D, GEAR_FIRST }, { D, GEAR_FIRST }, { N, GEAR_REFUSE } },
+};
+
+// Applies `request` to (selector, forward). False, with both untouched, if it is refused.
+inline bool gear_transition(ShiftRequest request, int forward_gears, uint8_t& selector, uint8_t& forward)
+{
+    const GearTransition& t = GEAR_TRANSITIONS[selector][request];
+    int next;
+    switch (t.step) {
+        case GEAR_NONE: next = 0; break;
+        case GEAR_KEEP: next = forward; break;
+        case GEAR_FIRST: next = 1; break;
+        case GEAR_UP: next = forward + 1; break;
+        case GEAR_DOWN: next = forward - 1; break;
+        default: return false;
+    }
+    if (next > forward_gears || (t.selector == D && next < 1)
+        || (t.selector == selector && next == forward)) {
+        return false;
+    }
+    selector = t.selector;
+    forward = (uint8_t)next;
+    return true;
+}
+
 class ITransmission
 {
     public:
         virtual bool to_park() = 0;
         virtual bool to_drive() = 0;
         virtual bool to_reverse() = 0;
+        virtual bool shift_up() = 0;
+        virtual bool shift_down() = 0;
         virtual bool is_in_park() const = 0;
         virtual Gear get_current_gear() const = 0;
+        virtual int get_forward_gear() const = 0;
         virtual ~ITransmission() {}
 };
 
 
-class Transmission : public ITransmission, public LoggerMixin<Engine>
+template <typename Sink>
+class TransmissionState : public LoggerMixin<Transmission, Sink>, public StateRecorder
 {
-    public:
-        static const std::string class_name;
+    protected:
+        TransmissionState(Sink* logger, const GearRatios& ratios = GearRatios())
+            : LoggerMixin<Transmission, Sink>(logger), _ratios(ratios), _current_gear(P), _forward_gear(0) {
+            this->template emit<EV_TRANSMISSION_INITIALIZED>(_current_gear);
+        }
 
-        Transmission(ILogger* logger) : LoggerMixin<Engine>(logger), _current_gear(P) {
-            log("Initialized in gear " + gear_to_string(_current_gear) + ".");
+        const GearRatios& gear_ratios() const { return _ratios; }
+        uint8_t selector() const { return (uint8_t)_current_gear; }
+        uint8_t forward() const { return _forward_gear; }
+        void store_gear(uint8_t selector, uint8_t forward) {
+            _current_gear = (Gear)selector;
+            _forward_gear = forward;
         }
 
+    private:
+        GearRatios _ratios;
+        Gear _current_gear;
+        uint8_t _forward_gear;
+};
+
+template <typename Sink, typename State = TransmissionState<Sink> >
+class BasicTransmission : public ITransmission, public State
+{
+    public:
+        template <typename... Args>
+        explicit BasicTransmission(Args&&... args) : State(std::forward<Args>(args)...) {}
+
         bool to_park() {
-            return _try_set(P);
+            return shift(SHIFT_PARK);
         }
 
         bool to_drive() {
-            return _try_set(D);
+            return shift(SHIFT_DRIVE);
         }
 
         bool to_reverse() {
-            return _try_set(R);
+            return shift(SHIFT_REVERSE);
         }
 
-        Gear get_current_gear() const {
-            return _current_gear;
+        bool shift_up() {
+            return shift(SHIFT_UP);
         }
 
-        bool is_in_park() const {
-            return _current_gear == P;
+        bool shift_down() {
+            return shift(SHIFT_DOWN);
         }
 
-    private:
-        Gear _current_gear;
-    
-    private:
-        bool _try_set(Gear gear) {
-            if (gear == _current_gear) {
-                return false; // Already in the desired gear
+        bool shift(ShiftRequest request) {
+            uint8_t selector = this->selector();
+            uint8_t forward = this->forward();
+            if (!gear_transition(request, this->gear_ratios().forward_gears, selector, forward)) {
+                return false;
+            }
+            bool selector_changed = selector != this->selector();
+            bool forward_changed = forward != this->forward();
+            this->store_gear(selector, forward);
+            if (selector_changed) {
+                this->record_state(FIELD_GEAR, selector);
+            }
+            if (forward_changed) {
+                this->record_state(FIELD_FORWARD_GEAR, forward);
+            }
+            if (selector_changed) {
+                this->template emit<EV_GEAR_CHANGED>((Gear)selector);
+            } else {
+                this->template emit<EV_FORWARD_GEAR_CHANGED>(forward);
             }
-            _current_gear = gear;
-            log("Gear -> " + gear_to_string(_current_gear) + ".");
-            return true; // Can shift to the desired gear
+            return true;
+        }
+
+        Gear get_current_gear() const {
+            return (Gear)this->selector();
+        }
+
+        int get_forward_gear() const {
+            return this->forward();
+        }
+
+        const GearRatios& ratios() const {
+            return this->gear_ratios();
+        }
+
+        bool is_in_park() const {
+            return get_current_gear() == P;
         }
 };
+
+class Transmission : public BasicTransmission<ILogger>
+{
+    public:
+        static const std::string class_name;
+
+        Transmission(ILogger* logger, const GearRatios& ratios = GearRatios())
+            : BasicTransmission<ILogger>(logger, ratios) {}
+};
 const std::string Transmission::class_name = "Transmission";
 
 class ISteeringSystem
@@ -232,34 +857,67 @@ class ISteeringSystem
         virtual ~ISteeringSystem() {}
 };
 
-class SteeringSystem : public ISteeringSystem, public LoggerMixin<SteeringSystem>
+template <typename Sink>
+class SteeringState : public LoggerMixin<SteeringSystem, Sink>, public StateRecorder
 {
-    public:
-        static const std::string class_name;
-        
-        SteeringSystem(ILogger* logger) : LoggerMixin<SteeringSystem>(logger), _current_angle(0) {
-            log("system initialized with wheels straightened.");
+    protected:
+        SteeringState(Sink* logger) : LoggerMixin<SteeringSystem, Sink>(logger), _current_angle(0) {
+            this->template emit<EV_STEERING_INITIALIZED>();
         }
 
+        int angle() const { return _current_angle; }
+        void store_angle(int angle) { _current_angle = angle; }
+
+    private:
+        int _current_angle;
+};
+
+template <typename Sink, typename State = SteeringState<Sink> >
+class BasicSteeringSystem : public ISteeringSystem, public State
+{
+    public:
+        static const int MAX_TURN_ANGLE = 45;
+
+        template <typename... Args>
+        explicit BasicSteeringSystem(Args&&... args) : State(std::forward<Args>(args)...) {}
+
         bool turn_wheel(int angle) {
             if (angle < -MAX_TURN_ANGLE || angle > MAX_TURN_ANGLE) {
-                log("Invalid angle. Must be between " + std::to_string(-MAX_TURN_ANGLE) + " and " + std::to_string(MAX_TURN_ANGLE) + ".");
+                this->template emit<EV_STEERING_INVALID_ANGLE>(-MAX_TURN_ANGLE, MAX_TURN_ANGLE);
                 return false;
             }
-            _current_angle = angle;
-            log("Wheels turned to " + std::to_string(angle) + " degrees.");
+            _set_angle(angle);
+            this->template emit<EV_WHEELS_TURNED>(angle);
             return true;
         }
         void straighten_wheels() {
-            _current_angle = 0;
-            log("Wheels straightened to the straight-ahead position.");
+            _set_angle(0);
+            this->template emit<EV_WHEELS_STRAIGHTENED>();
+        }
+
+        int get_current_angle() const {
+            return this->angle();
         }
 
     private:
-        static const int MAX_TURN_ANGLE = 45;
-        int _current_angle;
+        void _set_angle(int angle) {
+            if (angle != this->angle()) {
+                this->store_angle(angle);
+                this->record_state(FIELD_STEERING_ANGLE, angle);
+            }
+        }
+};
+
+class SteeringSystem : public BasicSteeringSystem<ILogger>
+{
+    public:
+        static const std::string class_name;
+
+        SteeringSystem(ILogger* logger)
+            : BasicSteeringSystem<ILogger>(logger) {}
 };
 const std::string SteeringSystem::class_name = "SteeringSystem";
+template <typename Sink, typename State> const int BasicSteeringSystem<Sink, State>::MAX_TURN_ANGLE;
 
 class IBrakingSystem
 {
@@ -271,42 +929,71 @@ class IBrakingSystem
         virtual ~IBrakingSystem() {}
 };
 
-class BrakingSystem : public IBrakingSystem, public LoggerMixin<BrakingSystem>
+template <typename Sink>
+class BrakingState : public LoggerMixin<BrakingSystem, Sink>, public StateRecorder
+{
+    protected:
+        BrakingState(Sink* logger) : LoggerMixin<BrakingSystem, Sink>(logger), _current_force(0) {
+            this->template emit<EV_BRAKES_INITIALIZED>();
+        }
+
+        int force() const { return _current_force; }
+        void store_force(int force) { _current_force = force; }
+
+    private:
+        int _current_force;
+};
+
+template <typename Sink, typename State = BrakingState<Sink> >
+class BasicBrakingSystem : public IBrakingSystem, public State
 {
     public:
-        static const std::string class_name;
+        static const int MAX_BRAKE_FORCE = 100; // Example maximum force
+
+        template <typename... Args>
+        explicit BasicBrakingSystem(Args&&... args) : State(std::forward<Args>(args)...) {}
 
-        BrakingSystem(ILogger* logger) : LoggerMixin<BrakingSystem>(logger){
-            _current_force = 0;
-            log("Braking system initialized.");
-        }
         bool apply_force_on_brakes(int force) {
             if (force < 0 || force > MAX_BRAKE_FORCE) {
-                log("Invalid force. Must be between 0 and " + std::to_string(MAX_BRAKE_FORCE) + ".");
+                this->template emit<EV_BRAKES_INVALID_FORCE>(MAX_BRAKE_FORCE);
                 return false;
             }
-            _current_force = force;
-            log("Brakes applied with force: " + std::to_string(force));
+            _set_force(force);
+            this->template emit<EV_BRAKES_APPLIED>(force);
             return true;
         }
         void apply_emergency_brakes() {
-            _current_force = MAX_BRAKE_FORCE;
-            log("Emergency brakes applied with maximum force: " + std::to_string(MAX_BRAKE_FORCE));
+            _set_force(MAX_BRAKE_FORCE);
+            this->template emit<EV_EMERGENCY_BRAKES>(MAX_BRAKE_FORCE);
         }
 
         int get_current_force() const {
-            return _current_force;
+            return this->force();
         }
 
         bool is_braking() const {
-            return _current_force > 0;
+            return this->force() > 0;
         }
-    
+
     private:
-        static const int MAX_BRAKE_FORCE = 100; // Example maximum force
-        int _current_force;
+        void _set_force(int force) {
+            if (force != this->force()) {
+                this->store_force(force);
+                this->record_state(FIELD_BRAKE_FORCE, force);
+            }
+        }
+};
+
+class BrakingSystem : public BasicBrakingSystem<ILogger>
+{
+    public:
+        static const std::string class_name;
+
+        BrakingSystem(ILogger* logger)
+            : BasicBrakingSystem<ILogger>(logger) {}
 };
 const std::string BrakingSystem::class_name = "BrakingSystem";
+template <typename Sink, typename State> const int BasicBrakingSystem<Sink, State>::MAX_BRAKE_FORCE;
 
 class ICarPolicy
 {
@@ -374,61 +1061,60 @@ class DefaultCarPolicy : public ICarPolicy
         }
 };
 
-class Car : public LoggerMixin<Car>
+template <typename Sink>
+class BasicCar : public LoggerMixin<Car, Sink>
 {
     public:
-        static const std::string class_name;
-
-        Car(ILogger* logger,
-            IEngine& eng,
-            ITransmission& trans,
-            ISteeringSystem& ss,
-            IBrakingSystem& bs,
-            ICarPolicy& policy)
-            : LoggerMixin<Car>(logger), _engine(eng), _transmission(trans), _steering_system(ss), _braking_system(bs), _policy(policy) {
-            log("Initialized with all systems ready.");
+        BasicCar(Sink* logger,
+                 IEngine& eng,
+                 ITransmission& trans,
+                 ISteeringSystem& ss,
+                 IBrakingSystem& bs,
+                 ICarPolicy& policy)
+            : LoggerMixin<Car, Sink>(logger), _engine(eng), _transmission(trans), _steering_system(ss), _braking_system(bs), _policy(policy) {
+            this->template emit<EV_CAR_INITIALIZED>();
         }
 
         void start() {
             _braking_system.apply_emergency_brakes(); // Ensure brakes are applied before starting
             if (!_policy.can_start(_engine, _transmission, _braking_system)) {
-                log("Start rejected by policy.");
+                this->template emit<EV_CAR_START_REJECTED>();
                 return;
             }
             _engine.start();
-            log("Started, braking system holding emergency brakes.");
+            this->template emit<EV_CAR_STARTED>();
         }
 
         void stop() {
             _transmission.to_park(); // Ensure transmission is in Park before stopping
             if (!_policy.can_stop(_engine, _transmission)) {
-                log("Stop rejected by policy.");
+                this->template emit<EV_CAR_STOP_REJECTED>();
                 return;
             }
             _engine.stop();
-            log("Stopped and transmission set to Park.");
+            this->template emit<EV_CAR_STOPPED>();
         }
 
         void accelerate(int speed) {
             if (!_policy.can_accelerate(_engine, _transmission, _braking_system)) {
-                log("Acceleration rejected by policy.");
+                this->template emit<EV_CAR_ACCELERATION_REJECTED>();
                 return;
             }
             _engine.accelerate(speed);
         }
 
         void shift_gears_up() {
-            _transmission.to_park();
+            _transmission.shift_up();
         }
 
         void shift_gears_down() {
-            _transmission.to_drive();
+            _transmission.shift_down();
         }
 
         void reverse() {
             _braking_system.apply_emergency_brakes();
             if (!_policy.can_reverse(_braking_system)) {
-                log("Reverse rejected by policy.");
+                this->template emit<EV_CAR_REVERSE_REJECTED>();
                 return;
             }
             _transmission.to_reverse();
@@ -458,4 +1144,73 @@ class Car : public LoggerMixin<Car>
         ICarPolicy& _policy;
 };
 
+class Car : public BasicCar<ILogger>
+{
+    public:
+        static const std::string class_name;
+
+        Car(ILogger* logger,
+            IEngine& eng,
+            ITransmission& trans,
+            ISteeringSystem& ss,
+            IBrakingSystem& bs,
+            ICarPolicy& policy)
+            : BasicCar<ILogger>(logger, eng, trans, ss, bs, policy) {}
+};
 const std::string Car::class_name = "Car";
+
+inline const char* component_name(ComponentId id)
+{
+    switch (id) { case COMPONENT_ENGINE: return Engine::class_name.c_str();
+                  case COMPONENT_TRANSMISSION: return Transmission::class_name.c_str();
+                  case COMPONENT_STEERING: return SteeringSystem::class_name.c_str();
+                  case COMPONENT_BRAKING: return BrakingSystem::class_name.c_str();
+                  case COMPONENT_CAR: return Car::class_name.c_str();
+                  default: return "?"; }
+}
+
+inline const char* component_color(ComponentId id)
+{
+    switch (id) { case COMPONENT_ENGINE: return LogColor<Engine>::color();
+                  case COMPONENT_TRANSMISSION: return LogColor<Transmission>::color();
+                  case COMPONENT_STEERING: return LogColor<SteeringSystem>::color();
+                  case COMPONENT_BRAKING: return LogColor<BrakingSystem>::color();
+                  case COMPONENT_CAR: return LogColor<Car>::color();
+                  default: return ansi::RESET; }
+}
+
+inline void render_event_arg(LogBuffer& line, EventArg type, int32_t value)
+{
+    if (type == ARG_GEAR) {
+        line << gear_to_string((Gear)value);
+    } else if (type == ARG_COUNT && value >= 1000) {
+        render_event_arg(line, type, value / 1000); // 9999 -> "9,999"
+        char group[4] = { ',', (char)('0' + value / 100 % 10), (char)('0' + value / 10 % 10), (char)('0' + value % 10) };
+        line.append(group, sizeof(group));
+    } else {
+        line << (int)value;
+    }
+}
+
+// Catalogue text with each `{}` replaced by its payload field.
+inline void render_event(LogBuffer& line, LogEvent ev, const int32_t* args)
+{
+    const EventInfo& info = event_info(ev);
+    const char* run = info.text;
+    const char* hole;
+    for (int n = 0; n < 2 && (hole = std::strstr(run, "{}")) != NULL; ++n) {
+        line.append(run, hole - run);
+        render_event_arg(line, info.args[n], args[n]);
+        run = hole + 2;
+    }
+    line << run;
+}
+
+// Renders a record exactly like LoggerMixin::log would have printed it.
+inline void render_record(LogBuffer& line, const LogRecord& r)
+{
+    ComponentId id = (ComponentId)r.component;
+    line << component_color(id) << component_name(id) << ": ";
+    render_event(line, (LogEvent)r.event, r.args);
+    line << ansi::RESET;
+}
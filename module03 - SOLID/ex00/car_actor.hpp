@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.hpp"
+#include "car.hpp"
+#include "car_command.hpp"
+
+/*
+CarActorSystem: every Car becomes an actor with its own mailbox, driven
+by a few worker threads.
+
+    send(actor, command)    any thread, lock-free; false if the mailbox is full,
+                            throws for an actor that was never spawned
+    worker                  takes a ready actor, runs up to `batch` of its
+                            commands through apply_command, puts it back if
+                            more arrived
+
+An actor is in the ready queue at most once, guarded by its `scheduled`
+flag: the send that finds the flag clear queues the actor, and a worker
+clears it only after its batch. So one worker at a time touches a Car and
+its parts, which need no locks of their own, and commands from one sender
+run in the order sent. The mailboxes and the ready queue are BoundedQueues;
+neither senders nor workers take a lock anywhere on the message path. A
+worker that finds the ready queue empty IDLE_POLLS times in a row parks on
+a condition variable; a send that queues an actor takes the mutex to wake
+one only when some worker is parked.
+
+Actors are added before start(), commands sent between start() and
+stop(). Cars log from
+the worker threads: give them a thread-safe logger.
+*/
+
+class CarActorSystem
+{
+    public:
+        static const int IDLE_POLLS = 64;
+
+        CarActorSystem(std::size_t workers, std::size_t mailbox_capacity = 256, std::size_t batch = 64)
+            : _workers(workers ? workers : 1), _mailbox_capacity(mailbox_capacity), _batch(batch ? batch : 1),
+              _in_flight(0), _processed(0), _running(false), _parked(0) {}
+
+        ~CarActorSystem() {
+            stop();
+        }
+
+        std::size_t spawn(Car& car) {
+            if (_running.load(std::memory_order_relaxed)) {
+                throw std::runtime_error("Actors must be spawned before start()");
+            }
+            _actors.push_back(std::unique_ptr<Actor>(new Actor(car, _mailbox_capacity)));
+            return _actors.size() - 1;
+        }
+
+        std::size_t size() const { return _actors.size(); }
+        std::size_t workers() const { return _workers; }
+
+        void start() {
+            if (_running.load(std::memory_order_relaxed)) {
+                return;
+            }
+            // Room for every actor plus one slot per worker still being popped: a push
+            // can find the slot a worker has claimed but not yet released.
+            _ready.reset(new BoundedQueue<Actor*>(_actors.size() + _workers));
+            _running.store(true, std::memory_order_release);
+            for (std::size_t w = 0; w < _workers; ++w) {
+                _threads.push_back(std::thread(&CarActorSystem::_serve, this));
+            }
+        }
+
+        // Commands still queued are dropped and no longer count as in flight, so
+        // wait_idle() returns; the system can be started again.
+        void stop() {
+            if (!_running.exchange(false)) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _wake.notify_all();
+            }
+            for (std::size_t i = 0; i < _threads.size(); ++i) {
+                _threads[i].join();
+            }
+            _threads.clear();
+            CarCommand dropped;
+            for (std::size_t i = 0; i < _actors.size(); ++i) {
+                while (_actors[i]->mailbox.pop(dropped)) {
+                }
+                _actors[i]->scheduled.store(false, std::memory_order_relaxed);
+            }
+            _ready.reset();
+            _in_flight.store(0, std::memory_order_release);
+        }
+
+        bool send(std::size_t actor, const CarCommand& command) {
+            if (!_running.load(std::memory_order_relaxed)) {
+                throw std::runtime_error("Actor system is not running");
+            }
+            if (actor >= _actors.size()) {
+                throw std::runtime_error("Unknown actor");
+            }
+            Actor& a = *_actors[actor];
+            _in_flight.fetch_add(1, std::memory_order_relaxed);
+            if (!a.mailbox.push(command)) {
+                _in_flight.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            _schedule(a);
+            return true;
+        }
+
+        // Returns once every command sent before the call has run.
+        void wait_idle() const {
+            while (_in_flight.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+
+        std::size_t processed() const { return _processed.load(std::memory_order_relaxed); }
+
+    private:
+        struct Actor {
+            Car& car;
+            BoundedQueue<CarCommand> mailbox;
+            std::atomic<bool> scheduled;
+
+            Actor(Car& car, std::size_t capacity) : car(car), mailbox(capacity), scheduled(false) {}
+        };
+
+        std::size_t _workers;
+        std::size_t _mailbox_capacity;
+        std::size_t _batch;
+        std::vector<std::unique_ptr<Actor> > _actors;
+        std::unique_ptr<BoundedQueue<Actor*> > _ready;  // each actor at most once
+        std::vector<std::thread> _threads;
+        std::atomic<std::size_t> _in_flight;
+        std::atomic<std::size_t> _processed;
+        std::atomic<bool> _running;
+        std::atomic<std::size_t> _parked;   // workers waiting on _wake
+        std::mutex _mutex;
+        std::condition_variable _wake;
+
+    private:
+        void _schedule(Actor& a) {
+            if (!a.scheduled.exchange(true, std::memory_order_seq_cst)) {
+                while (!_ready->push(&a)) {
+                    std::this_thread::yield();
+                }
+                // Pairs with the fence in _park(): either the worker sees the actor or we see it parked.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (_parked.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _wake.notify_one();
+                }
+            }
+        }
+
+        // Sleeps until a send or stop() wakes it; returns at once if work arrived meanwhile.
+        void _park() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _parked.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!_ready->claimed() && _running.load(std::memory_order_relaxed)) {
+                _wake.wait(lock);
+            }
+            _parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void _serve() {
+            Actor* a;
+            int idle = 0;
+            while (_running.load(std::memory_order_relaxed)) {
+                if (!_ready->pop(a)) {
+                    if (++idle < IDLE_POLLS) {
+                        std::this_thread::yield();
+                    } else {
+                        _park();
+                        idle = 0;
+                    }
+                    continue;
+                }
+                idle = 0;
+                std::size_t n = 0;
+                CarCommand c;
+                while (n < _batch && a->mailbox.pop(c)) {
+                    apply_command(a->car, c);
+                    ++n;
+                }
+                _processed.fetch_add(n, std::memory_order_relaxed);
+                _in_flight.fetch_sub(n, std::memory_order_release);
+                // A send between the last pop and this store saw the flag set and left
+                // the actor to us: look again after clearing it.
+                a->scheduled.store(false, std::memory_order_seq_cst);
+                if (a->mailbox.claimed()) {
+                    _schedule(*a);
+                }
+            }
+        }
+
+    private:
+        CarActorSystem(const CarActorSystem&);
+        CarActorSystem& operator=(const CarActorSystem&);
+};
+const int CarActorSystem::IDLE_POLLS;
@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+#include "car.hpp"
+
+/*
+CarCommand: one public Car call as a 12-byte record.
+
+    { car, op, arg }    e.g. { 7, OP_TURN_WHEEL, 30 } is car 7's turn_wheel(30)
+
+`car` is whatever the executor uses to find the car (a world entity, a
+fleet index); `arg` is the speed, angle or force, 0 for calls without one.
+apply_command() runs a record on an ordinary Car, which defines what every
+other executor must reproduce.
+*/
+
+enum CarOp {
+    OP_START,
+    OP_STOP,
+    OP_ACCELERATE,
+    OP_SHIFT_UP,
+    OP_SHIFT_DOWN,
+    OP_REVERSE,
+    OP_TURN_WHEEL,
+    OP_STRAIGHTEN_WHEELS,
+    OP_APPLY_BRAKES,
+    OP_EMERGENCY_BRAKES,
+    OP_COUNT
+};
+
+struct CarCommand {
+    uint32_t car;
+    uint32_t op;
+    int32_t  arg;
+};
+
+inline CarCommand car_command(uint32_t car, CarOp op, int32_t arg = 0)
+{
+    CarCommand c;
+    c.car = car;
+    c.op = op;
+    c.arg = arg;
+    return c;
+}
+
+template <typename Sink>
+inline void apply_command(BasicCar<Sink>& car, const CarCommand& c)
+{
+    switch (c.op) { case OP_START: car.start(); break;
+                    case OP_STOP: car.stop(); break;
+                    case OP_ACCELERATE: car.accelerate(c.arg); break;
+                    case OP_SHIFT_UP: car.shift_gears_up(); break;
+                    case OP_SHIFT_DOWN: car.shift_gears_down(); break;
+                    case OP_REVERSE: car.reverse(); break;
+                    case OP_TURN_WHEEL: car.turn_wheel(c.arg); break;
+                    case OP_STRAIGHTEN_WHEELS: car.straighten_wheels(); break;
+                    case OP_APPLY_BRAKES: car.apply_force_on_brakes(c.arg); break;
+                    case OP_EMERGENCY_BRAKES: car.apply_emergency_brakes(); break;
+                    default: break; }
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+
+#include "car.hpp"
+
+/*
+CompiledCarPolicy: DefaultCarPolicy's rules as one table lookup per query.
+
+The part states a policy looks at are packed into a 3-bit CarState:
+
+    STATE_ENGINE_ACTIVE | STATE_IN_PARK | STATE_BRAKING
+
+and every (action, state) pair is precomputed into a PolicyReason once, from
+policy_rule(), which walks the same checks in the same order as
+DefaultCarPolicy. A query is then a table load: no branch chain, and no
+stream write on rejection; the reason comes back as a code and
+policy_reason_text() gives DefaultCarPolicy's message when it is wanted.
+*/
+
+enum CarState {
+    STATE_ENGINE_ACTIVE = 1 << 0,
+    STATE_IN_PARK       = 1 << 1,
+    STATE_BRAKING       = 1 << 2,
+    STATE_COUNT         = 1 << 3
+};
+
+enum PolicyAction { ACTION_START, ACTION_STOP, ACTION_ACCELERATE, ACTION_REVERSE, ACTION_COUNT };
+
+enum PolicyReason {
+    POLICY_OK,
+    POLICY_ENGINE_ALREADY_RUNNING,
+    POLICY_START_NOT_IN_PARK,
+    POLICY_START_WITHOUT_BRAKES,
+    POLICY_ENGINE_NOT_RUNNING,
+    POLICY_STOP_NOT_IN_PARK,
+    POLICY_ACCELERATE_ENGINE_OFF,
+    POLICY_ACCELERATE_IN_PARK,
+    POLICY_ACCELERATE_WHILE_BRAKING,
+    POLICY_REVERSE_WITHOUT_BRAKES,
+    POLICY_REASON_COUNT
+};
+
+inline const char* policy_reason_text(PolicyReason reason)
+{
+    switch (reason) { case POLICY_OK: return "Allowed.";
+                      case POLICY_ENGINE_ALREADY_RUNNING: return "Engine is already running.";
+                      case POLICY_START_NOT_IN_PARK: return "Transmission must be in Park gear to start.";
+                      case POLICY_START_WITHOUT_BRAKES: return "Brakes must be applied before starting.";
+                      case POLICY_ENGINE_NOT_RUNNING: return "Engine is not running.";
+                      case POLICY_STOP_NOT_IN_PARK: return "Transmission must be in Park gear to stop.";
+                      case POLICY_ACCELERATE_ENGINE_OFF: return "Engine must be running to accelerate.";
+                      case POLICY_ACCELERATE_IN_PARK: return "Cannot accelerate while in Park gear.";
+                      case POLICY_ACCELERATE_WHILE_BRAKING: return "Cannot accelerate while brakes are applied.";
+                      case POLICY_REVERSE_WITHOUT_BRAKES: return "Brakes must be applied before reversing.";
+                      default: return "?"; }
+}
+
+inline unsigned car_state(bool engine_active, bool in_park, bool braking)
+{
+    return (engine_active ? STATE_ENGINE_ACTIVE : 0)
+         | (in_park ? STATE_IN_PARK : 0)
+         | (braking ? STATE_BRAKING : 0);
+}
+
+// DefaultCarPolicy's checks, in its order; only used to build the table.
+inline PolicyReason policy_rule(PolicyAction action, unsigned state)
+{
+    bool active = state & STATE_ENGINE_ACTIVE;
+    bool in_park = state & STATE_IN_PARK;
+    bool braking = state & STATE_BRAKING;
+    switch (action) {
+        case ACTION_START:
+            if (active) return POLICY_ENGINE_ALREADY_RUNNING;
+            if (!in_park) return POLICY_START_NOT_IN_PARK;
+            if (!braking) return POLICY_START_WITHOUT_BRAKES;
+            return POLICY_OK;
+        case ACTION_STOP:
+            if (!active) return POLICY_ENGINE_NOT_RUNNING;
+            if (!in_park) return POLICY_STOP_NOT_IN_PARK;
+            return POLICY_OK;
+        case ACTION_ACCELERATE:
+            if (!active) return POLICY_ACCELERATE_ENGINE_OFF;
+            if (in_park) return POLICY_ACCELERATE_IN_PARK;
+            if (braking) return POLICY_ACCELERATE_WHILE_BRAKING;
+            return POLICY_OK;
+        case ACTION_REVERSE:
+            if (!braking) return POLICY_REVERSE_WITHOUT_BRAKES;
+            return POLICY_OK;
+        default:
+            return POLICY_OK;
+    }
+}
+
+class CompiledCarPolicy : public ICarPolicy
+{
+    public:
+        CompiledCarPolicy() {
+            for (unsigned a = 0; a < ACTION_COUNT; ++a) {
+                for (unsigned s = 0; s < STATE_COUNT; ++s) {
+                    _table[a][s] = (uint8_t)policy_rule((PolicyAction)a, s);
+                }
+            }
+        }
+
+        PolicyReason check(PolicyAction action, unsigned state) const {
+            return (PolicyReason)_table[action][state & (STATE_COUNT - 1)];
+        }
+
+        static unsigned state_of(const IEngine& engine, const ITransmission& transmission, const IBrakingSystem& braking_system) {
+            return car_state(engine.is_active(), transmission.is_in_park(), braking_system.is_braking());
+        }
+
+        bool can_start(const IEngine& engine, const ITransmission& transmission, const IBrakingSystem& braking_system) const {
+            return check(ACTION_START, state_of(engine, transmission, braking_system)) == POLICY_OK;
+        }
+
+        bool can_stop(const IEngine& engine, const ITransmission& transmission) const {
+            return check(ACTION_STOP, car_state(engine.is_active(), transmission.is_in_park(), false)) == POLICY_OK;
+        }
+
+        bool can_accelerate(const IEngine& engine, const ITransmission& transmission, const IBrakingSystem& braking_system) const {
+            return check(ACTION_ACCELERATE, state_of(engine, transmission, braking_system)) == POLICY_OK;
+        }
+
+        bool can_reverse(const IBrakingSystem& braking_system) const {
+            return check(ACTION_REVERSE, car_state(false, false, braking_system.is_braking())) == POLICY_OK;
+        }
+
+    private:
+        uint8_t _table[ACTION_COUNT][STATE_COUNT];
+};
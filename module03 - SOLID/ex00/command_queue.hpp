@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "car_command.hpp"
+
+/*
+CarCommandQueue: one Car's commands, recorded as they arrive and run later
+in batches.
+
+Controllers push() CarCommand records (the `car` field is not used) from
+any thread; a push is a lock and an append. drain() takes everything
+queued so far, in one swap under the lock, and runs it on the Car through
+apply_command, in order, after dropping the commands a later one makes
+redundant:
+
+    steering      only the last valid turn_wheel / straighten_wheels of the
+                  batch runs; no policy and no other part reads the angle
+    accelerate    of adjacent calls only the last runs, so the policy is
+                  asked once; each call replaces the target speed
+    brakes        of adjacent apply_force_on_brakes / apply_emergency_brakes
+                  only the last valid one runs; each replaces the force
+
+"Adjacent" skips steering commands. An angle or force out of range changes
+nothing on the Car, so such commands are dropped rather than logged one
+by one. The parts end in the state running every command would have left
+them in. Each drain logs one CAR_BATCH_APPLIED summary: commands run and
+commands coalesced away.
+*/
+
+struct BatchStats {
+    std::size_t queued;
+    std::size_t run;
+    std::size_t coalesced;
+
+    BatchStats() : queued(0), run(0), coalesced(0) {}
+};
+
+class CarCommandQueue
+{
+    public:
+        CarCommandQueue(std::size_t capacity = 256) {
+            _pending.reserve(capacity);
+            _batch.reserve(capacity);
+        }
+
+        void push(CarOp op, int32_t arg = 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.push_back(car_command(0, op, arg));
+        }
+
+        void push(const CarCommand* commands, std::size_t count) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.insert(_pending.end(), commands, commands + count);
+        }
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _pending.size();
+        }
+
+        // Call from the thread that owns the Car.
+        template <typename Sink>
+        BatchStats drain(BasicCar<Sink>& car) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _batch.swap(_pending);
+            }
+            BatchStats stats;
+            stats.queued = _batch.size();
+            if (_batch.empty()) {
+                return stats;
+            }
+            _coalesce();
+            for (std::size_t i = 0; i < _batch.size(); ++i) {
+                if (_batch[i].op != DROPPED) {
+                    apply_command(car, _batch[i]);
+                    ++stats.run;
+                }
+            }
+            stats.coalesced = stats.queued - stats.run;
+            car.template emit<EV_CAR_BATCH_APPLIED>((int32_t)stats.run, (int32_t)stats.coalesced);
+            _batch.clear();
+            return stats;
+        }
+
+    private:
+        static const uint32_t DROPPED = OP_COUNT;
+
+        mutable std::mutex _mutex;
+        std::vector<CarCommand> _pending;
+        std::vector<CarCommand> _batch;  // owned by drain()
+
+    private:
+        // Back to front, so "a later command replaces this one" is known on arrival.
+        void _coalesce() {
+            bool steering_set = false;  // a later steering command runs
+            bool brakes_set = false;    // a later brake command of this run sets the force
+            uint32_t next = DROPPED;    // the next non-steering op
+            for (std::size_t i = _batch.size(); i-- > 0; ) {
+                CarCommand& c = _batch[i];
+                switch (c.op) {
+                    case OP_TURN_WHEEL:
+                    case OP_STRAIGHTEN_WHEELS:
+                        if (steering_set || !_valid(c)) {
+                            c.op = DROPPED;
+                        } else {
+                            steering_set = true;
+                        }
+                        continue;
+                    case OP_ACCELERATE:
+                        brakes_set = false;
+                        if (next == OP_ACCELERATE) {
+                            c.op = DROPPED;
+                            continue;
+                        }
+                        break;
+                    case OP_APPLY_BRAKES:
+                    case OP_EMERGENCY_BRAKES:
+                        if (brakes_set || !_valid(c)) {
+                            c.op = DROPPED;
+                        } else {
+                            brakes_set = true;
+                        }
+                        next = OP_APPLY_BRAKES;
+                        continue;
+                    default:
+                        brakes_set = false;
+                        break;
+                }
+                next = c.op;
+            }
+        }
+
+        static bool _valid(const CarCommand& c) {
+            const int max_angle = SteeringSystem::MAX_TURN_ANGLE;
+            const int max_force = BrakingSystem::MAX_BRAKE_FORCE;
+            switch (c.op) {
+                case OP_TURN_WHEEL: return c.arg >= -max_angle && c.arg <= max_angle;
+                case OP_APPLY_BRAKES: return c.arg >= 0 && c.arg <= max_force;
+                default: return true;
+            }
+        }
+
+    private:
+        CarCommandQueue(const CarCommandQueue&);
+        CarCommandQueue& operator=(const CarCommandQueue&);
+};
+const uint32_t CarCommandQueue::DROPPED;
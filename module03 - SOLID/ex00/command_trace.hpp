@@ -0,0 +1,288 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "car_actor.hpp"
+#include "car_command.hpp"
+#include "command_queue.hpp"
+#include "fleet_simulator.hpp"
+#include "record_file.hpp"
+
+/*
+Command traces: every public Car call, recorded with its time, to be fed
+back later.
+
+    CarRecorder     Car's public interface; each call is written to a
+                    TraceWriter as a CarCommand, then run on the wrapped
+                    Car through apply_command()
+    TraceWriter     <path>: a record file (record_file.hpp) of 24-byte
+                    TraceRecords in call order; times are nanoseconds
+                    since the writer was opened
+    TraceReplayer   reads a trace back, as fast as it goes (REPLAY_FAST) or
+                    keeping the recorded spacing (REPLAY_REAL_TIME), into:
+
+        replay(cars, count)         Car* per car id, through apply_command()
+        replay(queues, count)       CarCommandQueue* per car id; each
+                                    queue's owner drains it
+        replay(simulator)           FleetSimulator::submit(); the commands
+                                    run on the simulator's next tick()
+        replay(actors)              CarActorSystem::send() to actor
+                                    `car`, waiting while its mailbox is full
+        replay(execute)             any callable taking const CarCommand&
+
+A trace replayed onto cars in the state the recorded ones started from
+leaves them in the same state: the calls run in recorded order, through
+the same apply_command() the recorder used. The simulator and the actor
+system keep each car's commands in that order too, so they end in the
+same state, and a recorded trace is a throughput input for them as it is.
+Records for car ids past the cars / queues / actors given are skipped.
+
+A TraceWriter is used by one thread at a time. Once a write has failed,
+record() and flush() throw for good (see RecordFileWriter); size() counts
+the records written and buffered, not those lost with the failed batch.
+*/
+
+struct TraceRecord {
+    uint64_t   timestamp_ns;
+    CarCommand command;
+    uint32_t   reserved;      // 0, keeps the record 8-byte aligned
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout is part of the trace format");
+
+static const char COMMAND_TRACE_MAGIC[8] = { 'C', 'A', 'R', 'T', 'R', 'A', 'C', 'E' };
+static const uint32_t COMMAND_TRACE_VERSION = 1;
+
+enum ReplayPace { REPLAY_FAST, REPLAY_REAL_TIME };
+
+class TraceWriter
+{
+    public:
+        static const std::size_t BUFFER_RECORDS = 1 << 12;
+
+        TraceWriter(const std::string& path)
+            : _file(path, COMMAND_TRACE_MAGIC, COMMAND_TRACE_VERSION, sizeof(TraceRecord), "command trace"),
+              _start(std::chrono::steady_clock::now()), _written(0) {
+            _buffer.reserve(BUFFER_RECORDS);
+        }
+
+        ~TraceWriter() {
+            _file.try_append(_buffer.data(), _buffer.size() * sizeof(TraceRecord));
+        }
+
+        void record(const CarCommand& command) {
+            _file.check();
+            TraceRecord r;
+            r.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - _start).count();
+            r.command = command;
+            r.reserved = 0;
+            _buffer.push_back(r);
+            if (_buffer.size() == BUFFER_RECORDS) {
+                _write();
+            }
+        }
+
+        void flush() {
+            _write();
+            _file.flush();
+        }
+
+        uint64_t size() const { return _written + _buffer.size(); }
+
+    private:
+        RecordFileWriter _file;
+        std::chrono::steady_clock::time_point _start;
+        uint64_t _written;
+        std::vector<TraceRecord> _buffer;
+
+    private:
+        // The batch leaves the buffer either way; if the write fails it is lost.
+        void _write() {
+            try {
+                _file.append(_buffer.data(), _buffer.size() * sizeof(TraceRecord));
+            } catch (...) {
+                _buffer.clear();
+                throw;
+            }
+            _written += _buffer.size();
+            _buffer.clear();
+        }
+
+        TraceWriter(const TraceWriter&);
+        TraceWriter& operator=(const TraceWriter&);
+};
+const std::size_t TraceWriter::BUFFER_RECORDS;
+
+// Car's public calls, recorded as those of car `id` before they run.
+class CarRecorder
+{
+    public:
+        CarRecorder(Car& car, TraceWriter& trace, uint32_t id = 0) : _car(car), _trace(trace), _id(id) {}
+
+        void start() { _call(OP_START); }
+        void stop() { _call(OP_STOP); }
+        void accelerate(int speed) { _call(OP_ACCELERATE, speed); }
+        void shift_gears_up() { _call(OP_SHIFT_UP); }
+        void shift_gears_down() { _call(OP_SHIFT_DOWN); }
+        void reverse() { _call(OP_REVERSE); }
+        void turn_wheel(int angle) { _call(OP_TURN_WHEEL, angle); }
+        void straighten_wheels() { _call(OP_STRAIGHTEN_WHEELS); }
+        void apply_force_on_brakes(int force) { _call(OP_APPLY_BRAKES, force); }
+        void apply_emergency_brakes() { _call(OP_EMERGENCY_BRAKES); }
+
+        Car& car() { return _car; }
+        uint32_t id() const { return _id; }
+
+    private:
+        Car& _car;
+        TraceWriter& _trace;
+        uint32_t _id;
+
+    private:
+        void _call(CarOp op, int32_t arg = 0) {
+            CarCommand c = car_command(_id, op, arg);
+            _trace.record(c);
+            apply_command(_car, c);
+        }
+};
+
+class TraceReplayer
+{
+    public:
+        static const std::size_t BLOCK_RECORDS = 1 << 12;
+
+        TraceReplayer(const std::string& path) : _file(std::fopen(path.c_str(), "rb")), _size(0) {
+            if (!_file) {
+                throw std::runtime_error("Cannot open command trace: " + path);
+            }
+            if (!read_record_file_header(_file, COMMAND_TRACE_MAGIC, COMMAND_TRACE_VERSION, sizeof(TraceRecord))) {
+                std::fclose(_file);
+                throw std::runtime_error("Not a command trace: " + path);
+            }
+            std::fseek(_file, 0, SEEK_END);
+            _size = ((uint64_t)std::ftell(_file) - sizeof(RecordFileHeader)) / sizeof(TraceRecord);
+        }
+
+        ~TraceReplayer() {
+            std::fclose(_file);
+        }
+
+        uint64_t size() const { return _size; }
+
+        // Time from the writer's opening to the last call.
+        std::chrono::nanoseconds duration() {
+            TraceRecord last;
+            if (_size == 0 || !_read_at(_size - 1, &last, 1)) {
+                return std::chrono::nanoseconds(0);
+            }
+            return std::chrono::nanoseconds(last.timestamp_ns);
+        }
+
+        // Calls execute(const CarCommand&) for every record, in order; returns the number of records.
+        template <typename Execute>
+        uint64_t replay(Execute&& execute, ReplayPace pace = REPLAY_FAST) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<TraceRecord> block(BLOCK_RECORDS);
+            uint64_t done = 0;
+            while (done < _size) {
+                std::size_t n = _read_at(done, block.data(), BLOCK_RECORDS);
+                if (n == 0) {
+                    break;
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    if (pace == REPLAY_REAL_TIME) {
+                        std::chrono::steady_clock::time_point due =
+                            start + std::chrono::nanoseconds(block[i].timestamp_ns);
+                        if (std::chrono::steady_clock::now() < due) {
+                            std::this_thread::sleep_until(due);
+                        }
+                    }
+                    execute(block[i].command);
+                }
+                done += n;
+            }
+            return done;
+        }
+
+        uint64_t replay(Car* const* cars, std::size_t count, ReplayPace pace = REPLAY_FAST) {
+            return replay(OntoCars(cars, count), pace);
+        }
+
+        uint64_t replay(CarCommandQueue* const* queues, std::size_t count, ReplayPace pace = REPLAY_FAST) {
+            return replay(OntoQueues(queues, count), pace);
+        }
+
+        uint64_t replay(FleetSimulator& simulator, ReplayPace pace = REPLAY_FAST) {
+            return replay(OntoSimulator(simulator), pace);
+        }
+
+        // The system must be started.
+        uint64_t replay(CarActorSystem& actors, ReplayPace pace = REPLAY_FAST) {
+            return replay(OntoActors(actors), pace);
+        }
+
+    private:
+        struct OntoCars {
+            Car* const* cars;
+            std::size_t count;
+            OntoCars(Car* const* cars, std::size_t count) : cars(cars), count(count) {}
+            void operator()(const CarCommand& c) const {
+                if (c.car < count) {
+                    apply_command(*cars[c.car], c);
+                }
+            }
+        };
+
+        struct OntoQueues {
+            CarCommandQueue* const* queues;
+            std::size_t count;
+            OntoQueues(CarCommandQueue* const* queues, std::size_t count) : queues(queues), count(count) {}
+            void operator()(const CarCommand& c) const {
+                if (c.car < count) {
+                    queues[c.car]->push(&c, 1);
+                }
+            }
+        };
+
+        struct OntoSimulator {
+            FleetSimulator& simulator;
+            OntoSimulator(FleetSimulator& simulator) : simulator(simulator) {}
+            void operator()(const CarCommand& c) const {
+                simulator.submit(c); // drops unknown cars itself
+            }
+        };
+
+        struct OntoActors {
+            CarActorSystem& actors;
+            OntoActors(CarActorSystem& actors) : actors(actors) {}
+            void operator()(const CarCommand& c) const {
+                if (c.car < actors.size()) {
+                    while (!actors.send(c.car, c)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        };
+
+        std::FILE* _file;
+        uint64_t _size;
+
+    private:
+        std::size_t _read_at(uint64_t first, TraceRecord* out, std::size_t count) {
+            if (std::fseek(_file, (long)(sizeof(RecordFileHeader) + first * sizeof(TraceRecord)), SEEK_SET) != 0) {
+                return 0;
+            }
+            return std::fread(out, sizeof(TraceRecord), count, _file);
+        }
+
+        TraceReplayer(const TraceReplayer&);
+        TraceReplayer& operator=(const TraceReplayer&);
+};
+const std::size_t TraceReplayer::BLOCK_RECORDS;
@@ -0,0 +1,159 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+#include "bicycle.hpp"
+#include "brake_curve.hpp"
+#include "fleet.hpp"
+#include "vectorize.hpp"
+
+/*
+VehicleDynamics: fixed-timestep motion for a whole fleet.
+
+Per car and per step of `dt` seconds, first along the car's axis:
+
+    throttle  = clamp(throttle_gain * (target_speed - |v|), 0, 1)   engine on
+    a_drive   = direction(gear) * throttle * max_accel              D +1, R -1, P 0
+    v        += (a_drive - drag * v) * dt
+    v        -> 0 by (rolling + brakes.decel(brake_force) + in_park * brakes.max_decel) * dt
+
+then heading, yaw rate and position from the new speed and the steering
+angle through the BicycleModel (see bicycle.hpp).
+
+Speed is signed (negative when reversing) in m/s. Brakes never push a car
+past standstill, and the constant rolling resistance stops a coasting car
+outright instead of leaving it to decay through denormal speeds (which
+are slow to compute).
+
+The inputs are the Fleet's columns and the outputs are float columns.
+Both passes are loops of straight-line float math with selects only,
+built with CAR_VECTORIZE.
+*/
+
+struct DynamicsParams {
+    float dt;             // s
+    float max_accel;      // m/s^2 at full throttle
+    BrakeCurve brakes;    // brake force -> m/s^2
+    float drag;           // 1/s
+    float rolling;        // m/s^2, always opposing motion
+    float wheelbase;      // m
+    float rear_ratio;     // rear axle to centre of mass, share of the wheelbase
+    float throttle_gain;  // throttle per m/s below the target speed
+
+    DynamicsParams()
+        : dt(1.0f / 60), max_accel(3.0f), brakes(), drag(0.02f),
+          rolling(0.15f), wheelbase(2.7f), rear_ratio(0.5f), throttle_gain(0.5f) {}
+};
+
+// Column pointers for one step; all have at least `end` entries.
+struct DynamicsInputs {
+    const uint8_t* engine_active;
+    const uint8_t* target_speed;  // km/h
+    const uint8_t* gear;
+    const uint8_t* brake_force;
+    const int8_t* steering_angle; // degrees
+};
+
+inline DynamicsInputs dynamics_inputs(const Fleet& fleet)
+{
+    DynamicsInputs in;
+    in.engine_active = fleet.engine_active();
+    in.target_speed = fleet.target_speed();
+    in.gear = fleet.gear();
+    in.brake_force = fleet.brake_force();
+    in.steering_angle = fleet.steering_angle();
+    return in;
+}
+
+class VehicleDynamics
+{
+    public:
+        VehicleDynamics(const DynamicsParams& params = DynamicsParams())
+            : _params(params), _bicycle(params.wheelbase, params.rear_ratio) {}
+
+        // New cars start at rest at the origin, heading 0 (along +x).
+        void resize(std::size_t count) {
+            _speed.resize(count, 0.0f);
+            _heading.resize(count, 0.0f);
+            _x.resize(count, 0.0f);
+            _y.resize(count, 0.0f);
+            _yaw_rate.resize(count, 0.0f);
+        }
+
+        std::size_t size() const { return _speed.size(); }
+        const DynamicsParams& params() const { return _params; }
+
+        float* speed() { return _speed.data(); }
+        float* heading() { return _heading.data(); }
+        float* x() { return _x.data(); }
+        float* y() { return _y.data(); }
+        const float* speed() const { return _speed.data(); }
+        const float* heading() const { return _heading.data(); }
+        const float* x() const { return _x.data(); }
+        const float* y() const { return _y.data(); }
+        const float* yaw_rate() const { return _yaw_rate.data(); }
+
+        void step(const Fleet& fleet) {
+            resize(fleet.size());
+            step(dynamics_inputs(fleet), 0, fleet.size());
+        }
+
+        // Cars [begin, end) only, so a fleet can be stepped in chunks.
+        void step(const DynamicsInputs& in, std::size_t begin, std::size_t end) {
+            integrate(_params, in, _speed.data(), begin, end);
+            BicycleColumns c;
+            c.speed = _speed.data();
+            c.steering_angle = in.steering_angle;
+            c.heading = _heading.data();
+            c.x = _x.data();
+            c.y = _y.data();
+            c.yaw_rate = _yaw_rate.data();
+            _bicycle.step(c, _params.dt, begin, end);
+        }
+
+        CAR_VECTORIZE
+        static void integrate(const DynamicsParams& p, const DynamicsInputs& in,
+                              float* __restrict speed, std::size_t begin, std::size_t end) {
+            const uint8_t* __restrict active = in.engine_active;
+            const uint8_t* __restrict target = in.target_speed;
+            const uint8_t* __restrict gear = in.gear;
+            const uint8_t* __restrict force = in.brake_force;
+            const float dt = p.dt;
+            const float accel_dt = p.max_accel * dt;
+            const float drag_dt = p.drag * dt;
+            const float per_force = 1.0f / BrakingSystem::MAX_BRAKE_FORCE;
+            const float brake_dt = p.brakes.max_decel * dt;
+            const float c1 = p.brakes.c1, c2 = p.brakes.c2, c3 = p.brakes.c3;
+            const float rolling = p.rolling * dt;
+            const float gain = p.throttle_gain;
+            const float kmh = 1.0f / 3.6f;
+
+            for (std::size_t i = begin; i < end; ++i) {
+                float v = speed[i];
+                float on = (float)(active[i] != 0);
+                float direction = (float)(gear[i] == D) - (float)(gear[i] == R);
+                float abs_v = v < 0 ? -v : v;
+                float throttle = gain * (target[i] * kmh - abs_v);
+                throttle = throttle < 0 ? 0 : throttle;
+                throttle = throttle > 1 ? 1 : throttle;
+                v += on * direction * throttle * accel_dt - drag_dt * v;
+
+                float t = force[i] * per_force;
+                float brake = rolling + (t * (c1 + t * (c2 + t * c3)) + (float)(gear[i] == P)) * brake_dt;
+                abs_v = v < 0 ? -v : v;
+                float slowed = abs_v > brake ? abs_v - brake : 0;
+                v = v < 0 ? -slowed : slowed;
+                speed[i] = v;
+            }
+        }
+
+    private:
+        DynamicsParams _params;
+        BicycleModel _bicycle;
+        std::vector<float> _speed;
+        std::vector<float> _heading;
+        std::vector<float> _x;
+        std::vector<float> _y;
+        std::vector<float> _yaw_rate;
+};
@@ -0,0 +1,330 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "car_command.hpp"
+#include "car_policy.hpp"
+
+/*
+CarWorld: cars as entity ids, parts as dense component arrays.
+
+    Entity   24-bit index + 8-bit generation; a destroyed car's id goes stale
+    slot     position of a live car in every component array
+
+All four arrays are indexed by the same slot, so a system that needs
+several parts of a car reads the same position in each; destroying a car
+moves the last car into its slot. Entities map to slots through one
+sparse table.
+
+CommandSystem runs CarCommands (car = Entity) with Car's semantics: the
+same order of part operations, the same checks, the same catalogued
+events, and a CompiledCarPolicy for the policy step. It works on the
+arrays directly, with no virtual calls or part objects. Events go to the
+world's logger as LogRecords through ComponentLog, so LogRate<Engine> & co.
+limit them as they do Car's, per part type and thread like the fleet
+handles, suppressed counts included; with no logger nothing is formatted
+or sent.
+*/
+
+typedef uint32_t Entity;
+
+static const Entity NO_ENTITY = 0xffffffffu;
+
+struct EngineComponent { uint8_t active; uint8_t target_speed; };
+struct TransmissionComponent { uint8_t gear; uint8_t forward; };
+struct SteeringComponent { int8_t angle; };
+struct BrakeComponent { uint8_t force; };
+
+// The part class whose LogRate and LogColor an event of component C goes through.
+template <ComponentId C> struct ComponentPart;
+template <> struct ComponentPart<COMPONENT_ENGINE> { typedef Engine type; };
+template <> struct ComponentPart<COMPONENT_TRANSMISSION> { typedef Transmission type; };
+template <> struct ComponentPart<COMPONENT_STEERING> { typedef SteeringSystem type; };
+template <> struct ComponentPart<COMPONENT_BRAKING> { typedef BrakingSystem type; };
+template <> struct ComponentPart<COMPONENT_CAR> { typedef Car type; };
+
+class CarWorld
+{
+    public:
+        CarWorld(ILogger* logger = NULL) : _logger(logger) {}
+
+        Entity create() {
+            uint32_t index;
+            if (!_free.empty()) {
+                index = _free.back();
+                _free.pop_back();
+            } else {
+                index = (uint32_t)_sparse.size();
+                if (index > INDEX_MASK) {
+                    throw std::runtime_error("CarWorld is full");
+                }
+                _sparse.push_back(NO_SLOT);
+                _generation.push_back(0);
+            }
+            Entity e = index | ((Entity)_generation[index] << INDEX_BITS);
+            _sparse[index] = (uint32_t)_entities.size();
+            _entities.push_back(e);
+            EngineComponent engine = { 0, 0 };
+            TransmissionComponent transmission = { (uint8_t)P, 0 };
+            SteeringComponent steering = { 0 };
+            BrakeComponent brake = { 0 };
+            _engines.push_back(engine);
+            _transmissions.push_back(transmission);
+            _steering.push_back(steering);
+            _brakes.push_back(brake);
+            return e;
+        }
+
+        void destroy(Entity e) {
+            if (!alive(e)) {
+                return;
+            }
+            uint32_t index = e & INDEX_MASK;
+            std::size_t slot = _sparse[index];
+            std::size_t last = _entities.size() - 1;
+            if (slot != last) {
+                _entities[slot] = _entities[last];
+                _engines[slot] = _engines[last];
+                _transmissions[slot] = _transmissions[last];
+                _steering[slot] = _steering[last];
+                _brakes[slot] = _brakes[last];
+                _sparse[_entities[slot] & INDEX_MASK] = (uint32_t)slot;
+            }
+            _entities.pop_back();
+            _engines.pop_back();
+            _transmissions.pop_back();
+            _steering.pop_back();
+            _brakes.pop_back();
+            _sparse[index] = NO_SLOT;
+            ++_generation[index];
+            _free.push_back(index);
+        }
+
+        bool alive(Entity e) const {
+            uint32_t index = e & INDEX_MASK;
+            return index < _sparse.size() && _sparse[index] != NO_SLOT
+                && _generation[index] == (uint8_t)(e >> INDEX_BITS);
+        }
+
+        // Slot of a live entity; NO_SLOT for a stale one.
+        std::size_t slot(Entity e) const {
+            return alive(e) ? _sparse[e & INDEX_MASK] : NO_SLOT;
+        }
+
+        Entity entity(std::size_t slot) const { return _entities[slot]; }
+        std::size_t size() const { return _entities.size(); }
+        ILogger* logger() const { return _logger; }
+
+        void reserve(std::size_t count) {
+            _entities.reserve(count);
+            _engines.reserve(count);
+            _transmissions.reserve(count);
+            _steering.reserve(count);
+            _brakes.reserve(count);
+        }
+
+        EngineComponent* engines() { return _engines.data(); }
+        TransmissionComponent* transmissions() { return _transmissions.data(); }
+        SteeringComponent* steering() { return _steering.data(); }
+        BrakeComponent* brakes() { return _brakes.data(); }
+
+        const EngineComponent* engines() const { return _engines.data(); }
+        const TransmissionComponent* transmissions() const { return _transmissions.data(); }
+        const SteeringComponent* steering() const { return _steering.data(); }
+        const BrakeComponent* brakes() const { return _brakes.data(); }
+
+        static const std::size_t NO_SLOT = 0xffffffffu;
+
+    private:
+        static const unsigned INDEX_BITS = 24;
+        static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+        ILogger* _logger;
+        std::vector<Entity> _entities;        // slot -> entity
+        std::vector<uint32_t> _sparse;        // entity index -> slot
+        std::vector<uint8_t> _generation;     // entity index -> current generation
+        std::vector<uint32_t> _free;          // entity indices to reuse
+        std::vector<EngineComponent> _engines;
+        std::vector<TransmissionComponent> _transmissions;
+        std::vector<SteeringComponent> _steering;
+        std::vector<BrakeComponent> _brakes;
+
+    private:
+        CarWorld(const CarWorld&);
+        CarWorld& operator=(const CarWorld&);
+};
+const std::size_t CarWorld::NO_SLOT;
+
+struct CommandStats {
+    std::size_t applied;
+    std::size_t rejected;   // refused by the policy
+    std::size_t invalid;    // angle / force out of range
+    std::size_t stale;      // entity no longer alive
+
+    CommandStats() : applied(0), rejected(0), invalid(0), stale(0) {}
+};
+
+class CommandSystem
+{
+    public:
+        CommandSystem(const CompiledCarPolicy& policy = CompiledCarPolicy(), const GearRatios& ratios = GearRatios())
+            : _policy(policy), _forward_gears(ratios.forward_gears) {}
+
+        // Commands run in order; a batch may mix any number of cars.
+        CommandStats run(CarWorld& world, const CarCommand* commands, std::size_t count) const {
+            CommandStats stats;
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t slot = world.slot(commands[i].car);
+                if (slot == CarWorld::NO_SLOT) {
+                    ++stats.stale;
+                    continue;
+                }
+                _apply(world, slot, (CarOp)commands[i].op, commands[i].arg, stats);
+            }
+            return stats;
+        }
+
+        // One command for every car, walking the arrays front to back.
+        CommandStats broadcast(CarWorld& world, CarOp op, int32_t arg = 0) const {
+            CommandStats stats;
+            for (std::size_t slot = 0; slot < world.size(); ++slot) {
+                _apply(world, slot, op, arg, stats);
+            }
+            return stats;
+        }
+
+    private:
+        CompiledCarPolicy _policy;
+        int _forward_gears;
+
+    private:
+        void _apply(CarWorld& w, std::size_t slot, CarOp op, int32_t arg, CommandStats& stats) const {
+            EngineComponent& engine = w.engines()[slot];
+            TransmissionComponent& transmission = w.transmissions()[slot];
+            SteeringComponent& steering = w.steering()[slot];
+            BrakeComponent& brake = w.brakes()[slot];
+            ILogger* sink = w.logger();
+            const int max_speed = Engine::MAX_TARGET_SPEED;
+            const int max_angle = SteeringSystem::MAX_TURN_ANGLE;
+            const int max_force = BrakingSystem::MAX_BRAKE_FORCE;
+
+            switch (op) {
+                case OP_START:
+                    _emergency_brakes(sink, brake);
+                    if (_policy.check(ACTION_START, _state(engine, transmission, brake)) != POLICY_OK) {
+                        _emit<EV_CAR_START_REJECTED>(sink);
+                        ++stats.rejected;
+                        return;
+                    }
+                    _emit<EV_ENGINE_STARTED>(sink);
+                    engine.active = 1;
+                    _emit<EV_CAR_STARTED>(sink);
+                    break;
+                case OP_STOP:
+                    _shift(sink, transmission, SHIFT_PARK);
+                    if (_policy.check(ACTION_STOP, car_state(engine.active, transmission.gear == P, false)) != POLICY_OK) {
+                        _emit<EV_CAR_STOP_REJECTED>(sink);
+                        ++stats.rejected;
+                        return;
+                    }
+                    _emit<EV_ENGINE_STOPPED>(sink);
+                    engine.active = 0;
+                    engine.target_speed = 0;
+                    _emit<EV_CAR_STOPPED>(sink);
+                    break;
+                case OP_ACCELERATE:
+                    if (_policy.check(ACTION_ACCELERATE, _state(engine, transmission, brake)) != POLICY_OK) {
+                        _emit<EV_CAR_ACCELERATION_REJECTED>(sink);
+                        ++stats.rejected;
+                        return;
+                    }
+                    _emit<EV_ENGINE_ACCELERATING>(sink, arg);
+                    engine.target_speed = (uint8_t)(arg < 0 ? 0 : arg > max_speed ? max_speed : arg);
+                    break;
+                case OP_SHIFT_UP:
+                    _shift(sink, transmission, SHIFT_UP);
+                    break;
+                case OP_SHIFT_DOWN:
+                    _shift(sink, transmission, SHIFT_DOWN);
+                    break;
+                case OP_REVERSE:
+                    _emergency_brakes(sink, brake);
+                    if (_policy.check(ACTION_REVERSE, car_state(false, false, brake.force > 0)) != POLICY_OK) {
+                        _emit<EV_CAR_REVERSE_REJECTED>(sink);
+                        ++stats.rejected;
+                        return;
+                    }
+                    _shift(sink, transmission, SHIFT_REVERSE);
+                    break;
+                case OP_TURN_WHEEL:
+                    if (arg < -max_angle || arg > max_angle) {
+                        _emit<EV_STEERING_INVALID_ANGLE>(sink, -max_angle, max_angle);
+                        ++stats.invalid;
+                        return;
+                    }
+                    steering.angle = (int8_t)arg;
+                    _emit<EV_WHEELS_TURNED>(sink, arg);
+                    break;
+                case OP_STRAIGHTEN_WHEELS:
+                    steering.angle = 0;
+                    _emit<EV_WHEELS_STRAIGHTENED>(sink);
+                    break;
+                case OP_APPLY_BRAKES:
+                    if (arg < 0 || arg > max_force) {
+                        _emit<EV_BRAKES_INVALID_FORCE>(sink, max_force);
+                        ++stats.invalid;
+                        return;
+                    }
+                    brake.force = (uint8_t)arg;
+                    _emit<EV_BRAKES_APPLIED>(sink, arg);
+                    break;
+                case OP_EMERGENCY_BRAKES:
+                    _emergency_brakes(sink, brake);
+                    break;
+                default:
+                    ++stats.invalid;
+                    return;
+            }
+            ++stats.applied;
+        }
+
+        static unsigned _state(const EngineComponent& e, const TransmissionComponent& t, const BrakeComponent& b) {
+            return car_state(e.active, t.gear == P, b.force > 0);
+        }
+
+        void _shift(ILogger* sink, TransmissionComponent& t, ShiftRequest request) const {
+            uint8_t before = t.gear;
+            if (!gear_transition(request, _forward_gears, t.gear, t.forward)) {
+                return;
+            }
+            if (t.gear != before) {
+                _emit<EV_GEAR_CHANGED>(sink, t.gear);
+            } else {
+                _emit<EV_FORWARD_GEAR_CHANGED>(sink, t.forward);
+            }
+        }
+
+        static void _emergency_brakes(ILogger* sink, BrakeComponent& b) {
+            b.force = (uint8_t)BrakingSystem::MAX_BRAKE_FORCE;
+            _emit<EV_EMERGENCY_BRAKES>(sink, BrakingSystem::MAX_BRAKE_FORCE);
+        }
+
+        // Same way as LoggerMixin::emit<E>: level filter, the part's LogRate, then one LogRecord.
+        template <LogEvent E, typename... Args>
+        static void _emit(ILogger* sink, Args... args) {
+            typedef typename ComponentPart<EventTraits<E>::component>::type Part;
+            if (EventTraits<E>::level < LOG_MIN_LEVEL || !sink) {
+                return;
+            }
+            ComponentLog<Part>::template emit<E>(sink, _rate<Part>(), args...);
+        }
+
+        template <typename Part>
+        static RateLimiter& _rate() {
+            static thread_local RateLimiter rate;
+            return rate;
+        }
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "car.hpp"
+
+/*
+EventHistory: the last N catalogued events of one car, kept in memory.
+
+Pass it as the logger of a car's components; every emit<>() lands here as a
+12-byte CompactEvent in a fixed ring (oldest entries are overwritten).
+Text is only produced when render() / dump() is called. Free-form log()
+lines have no catalogue id and are not kept.
+*/
+
+class EventHistory : public ILogger
+{
+    public:
+        EventHistory(std::size_t capacity = 256)
+            : _events(capacity ? capacity : 1), _next(0), _size(0) {}
+
+        void log(const std::string &) const {}
+        void write(const char*, std::size_t) const {}
+
+        void record(const LogRecord& r) const {
+            CompactEvent& e = _events[_next];
+            e.event = r.event;
+            e.component = r.component;
+            e.args[0] = r.args[0];
+            e.args[1] = r.args[1];
+            _next = (_next + 1) % _events.size();
+            if (_size < _events.size()) {
+                ++_size;
+            }
+        }
+
+        std::size_t size() const { return _size; }
+        std::size_t capacity() const { return _events.size(); }
+        std::size_t memory_bytes() const { return _events.size() * sizeof(CompactEvent); }
+
+        // 0 is the oldest event still kept.
+        const CompactEvent& operator[](std::size_t i) const {
+            return _events[(_next + _events.size() - _size + i) % _events.size()];
+        }
+
+        void render(std::size_t i, LogBuffer& line) const {
+            const CompactEvent& e = (*this)[i];
+            ComponentId id = (ComponentId)e.component;
+            line << component_color(id) << component_name(id) << ": ";
+            render_event(line, (LogEvent)e.event, e.args);
+            line << ansi::RESET;
+        }
+
+        // Replays the kept events, oldest first, as text lines into sink.
+        void dump(const ILogger& sink) const {
+            LogBuffer& line = LogBuffer::local();
+            for (std::size_t i = 0; i < _size; ++i) {
+                line.clear();
+                render(i, line);
+                sink.write(line.data(), line.size());
+            }
+        }
+
+        void clear() {
+            _next = 0;
+            _size = 0;
+        }
+
+    private:
+        mutable std::vector<CompactEvent> _events;
+        mutable std::size_t _next;
+        mutable std::size_t _size;
+};
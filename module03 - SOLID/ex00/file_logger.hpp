@@ -0,0 +1,172 @@
+#pragma once
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "car.hpp"
+
+/*
+FileLogger: batches lines and hands each batch to the kernel in one syscall.
+
+A batch is flushed as soon as one bound is reached:
+    - max_messages lines are pending
+    - max_bytes bytes are pending
+    - max_delay elapsed since the first pending line (checked on the next log)
+
+There is no timer: max_delay only bounds the delay while writes keep
+coming. A logger that goes quiet keeps its pending lines until the next
+write, flush() or its destruction; call flush() at points where the file
+must be current.
+
+Lines are appended to one contiguous buffer, so a batch is a single write();
+a line bigger than the whole buffer goes out with the pending batch through
+one writev() instead of being copied. flush() and the destructor write out
+whatever is pending.
+*/
+
+class FileLogger : public ILogger
+{
+    public:
+        FileLogger(const std::string& path,
+                   std::size_t max_messages = 1024,
+                   std::size_t max_bytes = 64 * 1024,
+                   std::chrono::milliseconds max_delay = std::chrono::milliseconds(50))
+            : _fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), _owns_fd(true) {
+            if (_fd < 0) {
+                throw std::runtime_error("Cannot open log file: " + path);
+            }
+            _init(max_messages, max_bytes, max_delay);
+        }
+
+        // Writes to an already open descriptor (e.g. STDOUT_FILENO), which is not closed.
+        FileLogger(int fd,
+                   std::size_t max_messages = 1024,
+                   std::size_t max_bytes = 64 * 1024,
+                   std::chrono::milliseconds max_delay = std::chrono::milliseconds(50))
+            : _fd(fd), _owns_fd(false) {
+            _init(max_messages, max_bytes, max_delay);
+        }
+
+        ~FileLogger() {
+            flush();
+            if (_owns_fd) {
+                ::close(_fd);
+            }
+        }
+
+        void log(const std::string &message) const {
+            write(message.data(), message.size());
+        }
+
+        void write(const char* data, std::size_t len) const {
+            if (_pending == 0) {
+                _first_pending = std::chrono::steady_clock::now();
+            } else if (std::chrono::steady_clock::now() - _first_pending >= _max_delay) {
+                flush();
+                _first_pending = std::chrono::steady_clock::now();
+            }
+            if (len + 1 > _buffer.capacity()) {
+                _write_through(data, len);
+                return;
+            }
+            if (_buffer.size() + len + 1 > _buffer.capacity()) {
+                flush();
+            }
+            _buffer.insert(_buffer.end(), data, data + len);
+            _buffer.push_back('\n');
+            if (++_pending >= _max_messages) {
+                flush();
+            }
+        }
+
+        void flush() const {
+            if (!_buffer.empty()) {
+                _write_all(&_buffer[0], _buffer.size());
+                _buffer.clear();
+            }
+            _pending = 0;
+        }
+
+        std::size_t syscalls() const {
+            return _syscalls;
+        }
+
+    private:
+        int _fd;
+        bool _owns_fd;
+        std::size_t _max_messages;
+        std::chrono::steady_clock::duration _max_delay;
+        mutable std::vector<char> _buffer;
+        mutable std::size_t _pending;
+        mutable std::chrono::steady_clock::time_point _first_pending;
+        mutable std::size_t _syscalls;
+
+    private:
+        FileLogger(const FileLogger&);
+        FileLogger& operator=(const FileLogger&);
+
+        void _init(std::size_t max_messages, std::size_t max_bytes, std::chrono::milliseconds max_delay) {
+            _max_messages = max_messages ? max_messages : 1;
+            _max_delay = max_delay;
+            _buffer.reserve(max_bytes ? max_bytes : 1);
+            _pending = 0;
+            _syscalls = 0;
+        }
+
+        // Pending batch + oversized line + newline in one writev().
+        void _write_through(const char* data, std::size_t len) const {
+            struct iovec iov[3];
+            int n = 0;
+            if (!_buffer.empty()) {
+                iov[n].iov_base = &_buffer[0];
+                iov[n++].iov_len = _buffer.size();
+            }
+            iov[n].iov_base = const_cast<char*>(data);
+            iov[n++].iov_len = len;
+            iov[n].iov_base = const_cast<char*>("\n");
+            iov[n++].iov_len = 1;
+
+            std::size_t total = _buffer.size() + len + 1;
+            ssize_t written;
+            do {
+                written = ::writev(_fd, iov, n);
+                ++_syscalls;
+            } while (written < 0 && errno == EINTR);
+            if (written < 0) {
+                written = 0; // _write_all retries what it can and gives up on the rest
+            }
+            if ((std::size_t)written < total) {
+                // Short or failed write: fall back to plain writes for the rest.
+                std::vector<char> rest;
+                rest.reserve(total);
+                rest.insert(rest.end(), _buffer.begin(), _buffer.end());
+                rest.insert(rest.end(), data, data + len);
+                rest.push_back('\n');
+                _write_all(&rest[written], total - written);
+            }
+            _buffer.clear();
+            _pending = 0;
+        }
+
+        void _write_all(const char* data, std::size_t len) const {
+            while (len > 0) {
+                ssize_t written = ::write(_fd, data, len);
+                ++_syscalls;
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return; // nowhere left to report a logging failure
+                }
+                data += written;
+                len -= written;
+            }
+        }
+};
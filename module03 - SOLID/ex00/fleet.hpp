@@ -0,0 +1,237 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+
+/*
+Fleet: the state of many cars' parts, one contiguous column per field.
+
+    engine_active   uint8_t   0 / 1
+    target_speed    uint8_t   km/h set by accelerate(), 0 .. 255
+    gear            uint8_t   Gear (the selector)
+    forward_gear    uint8_t   1 .. ratios().forward_gears in D, 0 otherwise
+    steering_angle  int8_t    -45 .. 45
+    brake_force     uint8_t   0 .. 100
+
+A car is an index. Bulk code (policies, dynamics) reads and writes the
+columns directly; a loop over one field touches only that field's bytes.
+
+FleetEngine, FleetTransmission, FleetSteeringSystem and FleetBrakingSystem
+are per-car handles onto those columns: BasicEngine & co. over a State that
+reads and writes the car's row, so they run the very code of Engine & co.
+and a Car can be built over them unchanged (see FleetCar). Adding a car
+logs nothing; a handle is a view and logs only on commands.
+
+With journal_to(), the handles also report every change they make to a
+column, under the car's index (see state_journal.hpp). Bulk code writing
+the columns directly is not journaled. A journal takes one thread at a
+time, so a journaled fleet's handles must be driven from one thread
+(FleetSimulator enforces it).
+*/
+
+class Fleet
+{
+    public:
+        Fleet(ILogger* logger, std::size_t count = 0, const GearRatios& ratios = GearRatios())
+            : _logger(logger), _journal(NULL), _ratios(ratios) {
+            if (!_logger) {
+                throw std::runtime_error("Logger cannot be null");
+            }
+            resize(count);
+        }
+
+        // New car in its initial state (engine off, P, wheels straight, no brakes).
+        std::size_t add() {
+            std::size_t id = size();
+            resize(id + 1);
+            return id;
+        }
+
+        void resize(std::size_t count) {
+            _engine_active.resize(count, 0);
+            _target_speed.resize(count, 0);
+            _gear.resize(count, P);
+            _forward_gear.resize(count, 0);
+            _steering_angle.resize(count, 0);
+            _brake_force.resize(count, 0);
+        }
+
+        void reserve(std::size_t count) {
+            _engine_active.reserve(count);
+            _target_speed.reserve(count);
+            _gear.reserve(count);
+            _forward_gear.reserve(count);
+            _steering_angle.reserve(count);
+            _brake_force.reserve(count);
+        }
+
+        std::size_t size() const { return _engine_active.size(); }
+        ILogger* logger() const { return _logger; }
+
+        void journal_to(IStateJournal* journal) { _journal = journal; }
+        IStateJournal* journal() const { return _journal; }
+
+        // Called by the handles after they change a column.
+        void record_state(std::size_t id, StateField field, int value) const {
+            if (_journal) {
+                _journal->append((uint32_t)id, field, value);
+            }
+        }
+        const GearRatios& ratios() const { return _ratios; }
+
+        uint8_t* engine_active() { return _engine_active.data(); }
+        uint8_t* target_speed() { return _target_speed.data(); }
+        uint8_t* gear() { return _gear.data(); }
+        uint8_t* forward_gear() { return _forward_gear.data(); }
+        int8_t* steering_angle() { return _steering_angle.data(); }
+        uint8_t* brake_force() { return _brake_force.data(); }
+
+        const uint8_t* engine_active() const { return _engine_active.data(); }
+        const uint8_t* target_speed() const { return _target_speed.data(); }
+        const uint8_t* gear() const { return _gear.data(); }
+        const uint8_t* forward_gear() const { return _forward_gear.data(); }
+        const int8_t* steering_angle() const { return _steering_angle.data(); }
+        const uint8_t* brake_force() const { return _brake_force.data(); }
+
+    private:
+        ILogger* _logger;
+        IStateJournal* _journal;
+        GearRatios _ratios;  // the same gearbox in every car
+        std::vector<uint8_t> _engine_active;
+        std::vector<uint8_t> _target_speed;
+        std::vector<uint8_t> _gear;
+        std::vector<uint8_t> _forward_gear;
+        std::vector<int8_t> _steering_angle;
+        std::vector<uint8_t> _brake_force;
+
+    private:
+        Fleet(const Fleet&);
+        Fleet& operator=(const Fleet&);
+};
+
+/*
+The handles' State (see BasicEngine in car.hpp): the Fleet and the index,
+not column pointers, since add() may move the columns. A handle is
+Fleet& + index + the part interface's vptr; events go to the fleet's
+logger, rate-limited per part type and thread (LogRate<Engine> & co. limit a
+fleet's cars together, from any number of threads).
+*/
+template <typename Part>
+class FleetPartState
+{
+    public:
+        // The car the handle stands for: car_id() of fleet().
+        const Fleet& fleet() const { return _fleet; }
+        std::size_t car_id() const { return _id; }
+
+    protected:
+        FleetPartState(Fleet& fleet, std::size_t id) : _fleet(fleet), _id(id) {}
+
+        template <LogEvent E, typename... Args>
+        void emit(Args... args) const {
+            ComponentLog<Part>::template emit<E>(_fleet.logger(), _rate(), args...);
+        }
+
+        void record_state(StateField field, int value) const {
+            _fleet.record_state(_id, field, value);
+        }
+
+        Fleet& _fleet;
+        std::size_t _id;
+
+    private:
+        static RateLimiter& _rate() {
+            static thread_local RateLimiter rate;
+            return rate;
+        }
+};
+
+class FleetEngineState : public FleetPartState<Engine>
+{
+    protected:
+        FleetEngineState(Fleet& fleet, std::size_t id) : FleetPartState<Engine>(fleet, id) {}
+
+        bool active() const { return _fleet.engine_active()[_id] != 0; }
+        int target_speed() const { return _fleet.target_speed()[_id]; }
+        void store_active(bool active) { _fleet.engine_active()[_id] = active; }
+        void store_target_speed(int speed) { _fleet.target_speed()[_id] = (uint8_t)speed; }
+};
+
+class FleetTransmissionState : public FleetPartState<Transmission>
+{
+    protected:
+        FleetTransmissionState(Fleet& fleet, std::size_t id) : FleetPartState<Transmission>(fleet, id) {}
+
+        const GearRatios& gear_ratios() const { return _fleet.ratios(); }
+        uint8_t selector() const { return _fleet.gear()[_id]; }
+        uint8_t forward() const { return _fleet.forward_gear()[_id]; }
+        void store_gear(uint8_t selector, uint8_t forward) {
+            _fleet.gear()[_id] = selector;
+            _fleet.forward_gear()[_id] = forward;
+        }
+};
+
+class FleetSteeringState : public FleetPartState<SteeringSystem>
+{
+    protected:
+        FleetSteeringState(Fleet& fleet, std::size_t id) : FleetPartState<SteeringSystem>(fleet, id) {}
+
+        int angle() const { return _fleet.steering_angle()[_id]; }
+        void store_angle(int angle) { _fleet.steering_angle()[_id] = (int8_t)angle; }
+};
+
+class FleetBrakingState : public FleetPartState<BrakingSystem>
+{
+    protected:
+        FleetBrakingState(Fleet& fleet, std::size_t id) : FleetPartState<BrakingSystem>(fleet, id) {}
+
+        int force() const { return _fleet.brake_force()[_id]; }
+        void store_force(int force) { _fleet.brake_force()[_id] = (uint8_t)force; }
+};
+
+class FleetEngine : public BasicEngine<ILogger, FleetEngineState>
+{
+    public:
+        FleetEngine(Fleet& fleet, std::size_t id) : BasicEngine<ILogger, FleetEngineState>(fleet, id) {}
+};
+
+class FleetTransmission : public BasicTransmission<ILogger, FleetTransmissionState>
+{
+    public:
+        FleetTransmission(Fleet& fleet, std::size_t id) : BasicTransmission<ILogger, FleetTransmissionState>(fleet, id) {}
+};
+
+class FleetSteeringSystem : public BasicSteeringSystem<ILogger, FleetSteeringState>
+{
+    public:
+        FleetSteeringSystem(Fleet& fleet, std::size_t id) : BasicSteeringSystem<ILogger, FleetSteeringState>(fleet, id) {}
+};
+
+class FleetBrakingSystem : public BasicBrakingSystem<ILogger, FleetBrakingState>
+{
+    public:
+        FleetBrakingSystem(Fleet& fleet, std::size_t id) : BasicBrakingSystem<ILogger, FleetBrakingState>(fleet, id) {}
+};
+
+// One fleet car driven through the ordinary Car class.
+class FleetCar
+{
+    public:
+        FleetCar(Fleet& fleet, std::size_t id, ICarPolicy& policy)
+            : engine(fleet, id), transmission(fleet, id), steering_system(fleet, id),
+              braking_system(fleet, id),
+              car(fleet.logger(), engine, transmission, steering_system, braking_system, policy) {}
+
+        FleetEngine engine;
+        FleetTransmission transmission;
+        FleetSteeringSystem steering_system;
+        FleetBrakingSystem braking_system;
+        Car car;
+
+    private:
+        FleetCar(const FleetCar&);
+        FleetCar& operator=(const FleetCar&);
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "car.hpp"
+#include "car_command.hpp"
+#include "dynamics.hpp"
+#include "fleet.hpp"
+#include "sim_arena.hpp"
+#include "work_stealing.hpp"
+
+/*
+FleetSimulator: one Car per fleet car, advanced a tick at a time on a
+WorkStealingPool.
+
+A tick runs, for every car, the commands submitted for it since the last
+tick (through Car, so with the policy checks and events of Car), then one
+VehicleDynamics step. The cars are cut into chunks of CHUNK consecutive
+cars, and a chunk is one pool task doing both for its cars. The Cars are
+built in fleet order in one SimulationArena.
+
+Results do not depend on the thread count: a car's state after a tick
+depends only on its own state and commands (run in submission order), and
+the chunks are fixed by CHUNK, never by the number of threads, so every car
+goes through the same code (vector body or scalar tail of the dynamics
+kernels) whichever thread gets its chunk. Only the interleaving of log
+records between chunks varies; the fleet's logger is called from all
+workers and must be thread-safe (NullLogger, AsyncLogger,
+MultiProducerLogger).
+
+A StateJournal is single-threaded, so a fleet with a journal attached
+(Fleet::journal_to) is only simulated on a one-thread pool: with more
+threads the constructor, and tick() should a journal be attached later,
+throw std::runtime_error. Call the journal's tick() between simulator
+ticks, from the same thread.
+*/
+
+class FleetSimulator
+{
+    public:
+        static const std::size_t CHUNK = 2048;
+
+        // One Car per car of `fleet`; the fleet must not be resized afterwards.
+        FleetSimulator(Fleet& fleet, ICarPolicy& policy, WorkStealingPool& pool,
+                       const DynamicsParams& params = DynamicsParams())
+            : _fleet(fleet), _pool(pool), _dynamics(params), _arena(CarFactory::bytes_for(fleet.size())), _ticks(0) {
+            _check_journal();
+            CarFactory factory(_arena, fleet.logger(), policy);
+            _cars.reserve(fleet.size());
+            for (std::size_t i = 0; i < fleet.size(); ++i) {
+                _cars.push_back(&factory.create(fleet, i));
+            }
+            _dynamics.resize(fleet.size());
+            _chunk_start.resize(_chunks() + 1);
+        }
+
+        std::size_t size() const { return _cars.size(); }
+        std::size_t ticks() const { return _ticks; }
+        const VehicleDynamics& dynamics() const { return _dynamics; }
+        Car& car(std::size_t i) { return _cars[i]->car; }
+
+        // For the next tick; `car` is the fleet index. Commands for unknown cars are dropped.
+        void submit(const CarCommand& command) {
+            _pending.push_back(command);
+        }
+
+        void submit(const CarCommand* commands, std::size_t count) {
+            _pending.insert(_pending.end(), commands, commands + count);
+        }
+
+        void tick() {
+            _check_journal();
+            _route();
+            _inputs = dynamics_inputs(_fleet);
+            _pool.run(_chunks(), *this);
+            _pending.clear();
+            ++_ticks;
+        }
+
+        // One pool task: chunk `c`'s commands, then its dynamics.
+        void operator()(std::size_t c) {
+            for (std::size_t i = _chunk_start[c]; i < _chunk_start[c + 1]; ++i) {
+                apply_command(_cars[_routed[i].car]->car, _routed[i]);
+            }
+            std::size_t begin = c * CHUNK;
+            std::size_t end = begin + CHUNK < size() ? begin + CHUNK : size();
+            _dynamics.step(_inputs, begin, end);
+        }
+
+    private:
+        Fleet& _fleet;
+        WorkStealingPool& _pool;
+        VehicleDynamics _dynamics;
+        SimulationArena _arena;
+        std::vector<FleetCar*> _cars;
+        std::vector<CarCommand> _pending;          // submission order
+        std::vector<CarCommand> _routed;           // grouped by chunk, submission order kept
+        std::vector<std::size_t> _chunk_start;     // chunk c's commands: [_chunk_start[c], _chunk_start[c + 1])
+        std::vector<std::size_t> _next;            // _route()'s write position per chunk
+        DynamicsInputs _inputs;
+        std::size_t _ticks;
+
+    private:
+        std::size_t _chunks() const {
+            return (size() + CHUNK - 1) / CHUNK;
+        }
+
+        // The handles append to the fleet's journal from whichever worker runs their chunk.
+        void _check_journal() const {
+            if (_fleet.journal() && _pool.threads() > 1) {
+                throw std::runtime_error("A journaled fleet can only be simulated on a one-thread pool");
+            }
+        }
+
+        // Stable counting sort of the pending commands by chunk.
+        void _route() {
+            std::fill(_chunk_start.begin(), _chunk_start.end(), 0);
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < _pending.size(); ++i) {
+                if (_pending[i].car < size()) {
+                    ++_chunk_start[_pending[i].car / CHUNK + 1];
+                    ++kept;
+                }
+            }
+            for (std::size_t c = 1; c < _chunk_start.size(); ++c) {
+                _chunk_start[c] += _chunk_start[c - 1];
+            }
+            _routed.resize(kept);
+            _next.assign(_chunk_start.begin(), _chunk_start.end() - 1);
+            for (std::size_t i = 0; i < _pending.size(); ++i) {
+                if (_pending[i].car < size()) {
+                    _routed[_next[_pending[i].car / CHUNK]++] = _pending[i];
+                }
+            }
+        }
+
+    private:
+        FleetSimulator(const FleetSimulator&);
+        FleetSimulator& operator=(const FleetSimulator&);
+};
+const std::size_t FleetSimulator::CHUNK;
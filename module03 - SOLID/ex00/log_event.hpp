@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+
+/*
+Event catalogue: every message a component can log, defined once.
+
+    X(name, component, level, arg0 type, arg1 type, text)
+
+The text uses `{}` for each payload field, in order. From this table we get
+the LogEvent ids, the compile-time level of each event (EventTraits), and
+the runtime table used to render text on demand (render_event in car.hpp).
+Binary logs store the ids, so new events go at the end.
+Components emit ids plus integers; nothing is formatted unless a text sink
+asks for it.
+
+A LogRecord is a fixed 24-byte layout (timestamp, component, event, three
+integer arguments). BinaryLogger stores it as-is; EventHistory keeps a
+12-byte CompactEvent instead.
+*/
+
+enum LogLevel { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR };
+
+enum ComponentId {
+    COMPONENT_UNKNOWN,
+    COMPONENT_ENGINE,
+    COMPONENT_TRANSMISSION,
+    COMPONENT_STEERING,
+    COMPONENT_BRAKING,
+    COMPONENT_CAR,
+    COMPONENT_COUNT
+};
+
+// How a payload field is stored (always an int32) and rendered.
+enum EventArg { ARG_NONE, ARG_INT, ARG_GEAR, ARG_COUNT };
+
+#define CAR_EVENT_CATALOGUE(X) \
+    X(ENGINE_INITIALIZED,          COMPONENT_ENGINE,       LOG_DEBUG, ARG_NONE, ARG_NONE, "Initialized.") \
+    X(ENGINE_STARTED,              COMPONENT_ENGINE,       LOG_INFO,  ARG_NONE, ARG_NONE, "Started.") \
+    X(ENGINE_STOPPED,              COMPONENT_ENGINE,       LOG_INFO,  ARG_NONE, ARG_NONE, "Stopped.") \
+    X(ENGINE_NOT_RUNNING,          COMPONENT_ENGINE,       LOG_WARN,  ARG_NONE, ARG_NONE, "Cannot accelerate. Engine is not running.") \
+    X(ENGINE_ACCELERATING,         COMPONENT_ENGINE,       LOG_TRACE, ARG_INT,  ARG_NONE, "Accelerating to {} km/h.") \
+    X(TRANSMISSION_INITIALIZED,    COMPONENT_TRANSMISSION, LOG_DEBUG, ARG_GEAR, ARG_NONE, "Initialized in gear {}.") \
+    X(GEAR_CHANGED,                COMPONENT_TRANSMISSION, LOG_TRACE, ARG_GEAR, ARG_NONE, "Gear -> {}.") \
+    X(STEERING_INITIALIZED,        COMPONENT_STEERING,     LOG_DEBUG, ARG_NONE, ARG_NONE, "system initialized with wheels straightened.") \
+    X(STEERING_INVALID_ANGLE,      COMPONENT_STEERING,     LOG_WARN,  ARG_INT,  ARG_INT,  "Invalid angle. Must be between {} and {}.") \
+    X(WHEELS_TURNED,               COMPONENT_STEERING,     LOG_TRACE, ARG_INT,  ARG_NONE, "Wheels turned to {} degrees.") \
+    X(WHEELS_STRAIGHTENED,         COMPONENT_STEERING,     LOG_TRACE, ARG_NONE, ARG_NONE, "Wheels straightened to the straight-ahead position.") \
+    X(BRAKES_INITIALIZED,          COMPONENT_BRAKING,      LOG_DEBUG, ARG_NONE, ARG_NONE, "Braking system initialized.") \
+    X(BRAKES_INVALID_FORCE,        COMPONENT_BRAKING,      LOG_WARN,  ARG_INT,  ARG_NONE, "Invalid force. Must be between 0 and {}.") \
+    X(BRAKES_APPLIED,              COMPONENT_BRAKING,      LOG_TRACE, ARG_INT,  ARG_NONE, "Brakes applied with force: {}") \
+    X(EMERGENCY_BRAKES,            COMPONENT_BRAKING,      LOG_INFO,  ARG_INT,  ARG_NONE, "Emergency brakes applied with maximum force: {}") \
+    X(CAR_INITIALIZED,             COMPONENT_CAR,          LOG_DEBUG, ARG_NONE, ARG_NONE, "Initialized with all systems ready.") \
+    X(CAR_STARTED,                 COMPONENT_CAR,          LOG_INFO,  ARG_NONE, ARG_NONE, "Started, braking system holding emergency brakes.") \
+    X(CAR_START_REJECTED,          COMPONENT_CAR,          LOG_WARN,  ARG_NONE, ARG_NONE, "Start rejected by policy.") \
+    X(CAR_STOPPED,                 COMPONENT_CAR,          LOG_INFO,  ARG_NONE, ARG_NONE, "Stopped and transmission set to Park.") \
+    X(CAR_STOP_REJECTED,           COMPONENT_CAR,          LOG_WARN,  ARG_NONE, ARG_NONE, "Stop rejected by policy.") \
+    X(CAR_ACCELERATION_REJECTED,   COMPONENT_CAR,          LOG_WARN,  ARG_NONE, ARG_NONE, "Acceleration rejected by policy.") \
+    X(CAR_REVERSE_REJECTED,        COMPONENT_CAR,          LOG_WARN,  ARG_NONE, ARG_NONE, "Reverse rejected by policy.") \
+    X(LOG_SUPPRESSED,              COMPONENT_UNKNOWN,      LOG_INFO,  ARG_COUNT, ARG_NONE, "suppressed {} messages") /* any component */ \
+    X(FORWARD_GEAR_CHANGED,        COMPONENT_TRANSMISSION, LOG_TRACE, ARG_INT,  ARG_NONE, "Gear -> D{}.") \
+    X(CAR_BATCH_APPLIED,           COMPONENT_CAR,          LOG_DEBUG, ARG_INT,  ARG_INT,  "Batch applied: {} commands run, {} coalesced.")
+
+enum LogEvent {
+    EV_NONE,
+#define CAR_EVENT_ENUM(name, component, level, arg0, arg1, text) EV_##name,
+    CAR_EVENT_CATALOGUE(CAR_EVENT_ENUM)
+#undef CAR_EVENT_ENUM
+    EV_COUNT
+};
+
+struct EventInfo {
+    ComponentId component;
+    LogLevel    level;
+    EventArg    args[2];
+    const char* text;
+};
+
+inline const EventInfo& event_info(LogEvent ev)
+{
+    static const EventInfo table[EV_COUNT] = {
+        { COMPONENT_UNKNOWN, LOG_TRACE, { ARG_NONE, ARG_NONE }, "unknown event." },
+#define CAR_EVENT_INFO(name, component, level, arg0, arg1, text) { component, level, { arg0, arg1 }, text },
+        CAR_EVENT_CATALOGUE(CAR_EVENT_INFO)
+#undef CAR_EVENT_INFO
+    };
+    return table[(unsigned)ev < EV_COUNT ? ev : EV_NONE];
+}
+
+// Compile-time view of the catalogue, used by LoggerMixin::emit<Event>().
+template <LogEvent E> struct EventTraits;
+
+#define CAR_EVENT_TRAITS(name, comp, lvl, arg0, arg1, text) \
+    template <> struct EventTraits<EV_##name> { \
+        static const ComponentId component = comp; \
+        static const LogLevel level = lvl; \
+        static const int arity = (arg0 != ARG_NONE) + (arg1 != ARG_NONE); \
+    };
+CAR_EVENT_CATALOGUE(CAR_EVENT_TRAITS)
+#undef CAR_EVENT_TRAITS
+
+struct LogRecord {
+    uint64_t timestamp_ns; // filled by sinks that keep time, 0 otherwise
+    uint16_t component;    // ComponentId
+    uint16_t event;        // LogEvent
+    int32_t  args[3];
+};
+
+static_assert(sizeof(LogRecord) == 24, "LogRecord layout is part of the binary log format");
+
+// In-memory form of a LogRecord, without the timestamp.
+struct CompactEvent {
+    uint16_t event;
+    uint16_t component;
+    int32_t  args[2];
+};
+
+static_assert(sizeof(CompactEvent) == 12, "CompactEvent must stay small enough for fleet-wide histories");
@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <cstring>
+
+#include "binary_logger.hpp"
+
+// logdecode [-t] <file>: prints a BinaryLogger / MmapLogger file in ConsoleLogger's text format.
+//   -t  prefixes each line with the record's timestamp (ns since epoch)
+// Decoding stops at the first EV_NONE record: the unused, zero-filled tail of an mmap segment.
+
+int main(int argc, char** argv) {
+    bool timestamps = argc == 3 && std::strcmp(argv[1], "-t") == 0;
+    if (argc != 2 && !timestamps) {
+        std::cerr << "usage: " << argv[0] << " [-t] <file>" << std::endl;
+        return 1;
+    }
+
+    const char* path = argv[argc - 1];
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+
+    if (!read_record_file_header(file, BINARY_LOG_MAGIC, BINARY_LOG_VERSION, sizeof(LogRecord))) {
+        std::cerr << path << ": not a binary car log" << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+
+    LogBuffer& line = LogBuffer::local();
+    LogRecord r;
+    while (std::fread(&r, sizeof(r), 1, file) == 1 && r.event != EV_NONE) {
+        line.clear();
+        if (timestamps) {
+            line << '[' << (unsigned long long)r.timestamp_ns << "] ";
+        }
+        render_record(line, r);
+        std::cout.write(line.data(), line.size()) << '\n';
+    }
+    std::fclose(file);
+    return 0;
+}
@@ -1,16 +1,26 @@
+#include <memory>
+
 #include "car.hpp"
+#include "binary_logger.hpp"
 
 
-int main() {
+// ./car --binary <file> records component events for ./logdecode instead of printing them.
+int main(int argc, char** argv) {
     ConsoleLogger console;
+    ILogger* sink = &console;
+    std::unique_ptr<BinaryLogger> binary;
+    if (argc == 3 && std::string(argv[1]) == "--binary") {
+        binary.reset(new BinaryLogger(argv[2], &console));
+        sink = binary.get();
+    }
 
     console.log("\n==== Initializing Car Components ====");
-    Engine engine(&console);
-    Transmission transmission(&console);
-    SteeringSystem steering_system(&console);
-    BrakingSystem braking_system(&console);
+    Engine engine(sink);
+    Transmission transmission(sink);
+    SteeringSystem steering_system(sink);
+    BrakingSystem braking_system(sink);
     DefaultCarPolicy policy;
-    Car car(&console, engine, transmission, steering_system, braking_system, policy);
+    Car car(sink, engine, transmission, steering_system, braking_system, policy);
 
     console.log("\n==== Car Simulation ====");
     car.start();
@@ -26,5 +36,8 @@ int main() {
     console.log("\n==== Car test policy====");
     car.stop();
 
+    if (binary) {
+        binary->flush(); // throws if the log could not be written whole
+    }
     return 0;
 }
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "binary_logger.hpp"
+
+/*
+MmapLogger: appends LogRecords into a pre-sized, memory-mapped file.
+
+Each segment uses the BinaryLogger layout (RecordFileHeader + LogRecords), so
+`logdecode` reads it. Logging a record is a memcpy into the shared mapping:
+no syscall per message, and because the pages belong to the kernel's page
+cache, whatever was written survives a crash of the simulation process.
+
+Crash-safe tail: a record's `event` field is stored last, after a release
+fence. The unused part of a segment is zero-filled, so a reader stops at
+the first record whose event is EV_NONE and never sees a torn record.
+
+When a segment is full the logger rotates to `<path>.1`, `<path>.2`, ...
+A segment closed normally is truncated to its used size. Segments left by
+an earlier run at the same path are removed when the logger opens, so a
+reader walking `<path>.N` never picks up a stale one.
+*/
+
+class MmapLogger : public ILogger
+{
+    public:
+        MmapLogger(const std::string& path,
+                   std::size_t segment_bytes = 4 << 20,
+                   ILogger* text_sink = NULL)
+            : _path(path), _text_sink(text_sink), _segment(0),
+              _fd(-1), _base(NULL), _cursor(0) {
+            std::size_t records = segment_bytes > sizeof(RecordFileHeader) + sizeof(LogRecord)
+                ? (segment_bytes - sizeof(RecordFileHeader)) / sizeof(LogRecord) : 1;
+            _size = sizeof(RecordFileHeader) + records * sizeof(LogRecord);
+            _remove_old_segments();
+            _open_segment();
+        }
+
+        ~MmapLogger() {
+            _close_segment();
+        }
+
+        void log(const std::string &message) const {
+            if (_text_sink) {
+                _text_sink->log(message);
+            }
+        }
+
+        void write(const char* data, std::size_t len) const {
+            if (_text_sink) {
+                _text_sink->write(data, len);
+            }
+        }
+
+        void record(const LogRecord& r) const {
+            if (_cursor + sizeof(LogRecord) > _size) {
+                _close_segment();
+                ++_segment;
+                _open_segment();
+            }
+            LogRecord stamped = r;
+            stamped.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            LogRecord* dst = reinterpret_cast<LogRecord*>(_base + _cursor);
+            uint16_t event = stamped.event;
+            stamped.event = EV_NONE;
+            std::memcpy(dst, &stamped, sizeof(stamped));
+            std::atomic_thread_fence(std::memory_order_release);
+            *reinterpret_cast<volatile uint16_t*>(&dst->event) = event;
+            _cursor += sizeof(LogRecord);
+        }
+
+        // Only needed to survive a machine crash; a process crash loses nothing.
+        void sync() const {
+            if (_base) {
+                ::msync(_base, _cursor, MS_SYNC);
+            }
+        }
+
+        std::size_t segments() const {
+            return _segment + 1;
+        }
+
+    private:
+        std::string _path;
+        ILogger* _text_sink;
+        std::size_t _size;
+        mutable std::size_t _segment;
+        mutable int _fd;
+        mutable char* _base;
+        mutable std::size_t _cursor;
+
+    private:
+        MmapLogger(const MmapLogger&);
+        MmapLogger& operator=(const MmapLogger&);
+
+        std::string _segment_path() const {
+            return _segment ? _path + "." + std::to_string(_segment) : _path;
+        }
+
+        // <path>.1, <path>.2, ... up to the first one missing.
+        void _remove_old_segments() const {
+            for (std::size_t i = 1; ::unlink((_path + "." + std::to_string(i)).c_str()) == 0; ++i) {
+            }
+        }
+
+        // On failure nothing is left open: _fd stays -1 and _base NULL.
+        void _open_segment() const {
+            std::string path = _segment_path();
+            int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot create log segment: " + path);
+            }
+            if (::ftruncate(fd, _size) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot size log segment: " + path);
+            }
+            void* base = ::mmap(NULL, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map log segment: " + path);
+            }
+            _fd = fd;
+            _base = static_cast<char*>(base);
+            RecordFileHeader header = record_file_header(BINARY_LOG_MAGIC, BINARY_LOG_VERSION, sizeof(LogRecord));
+            std::memcpy(_base, &header, sizeof(header));
+            _cursor = sizeof(header);
+        }
+
+        // Safe to call again: a segment already closed (e.g. a rotation that threw) is skipped.
+        void _close_segment() const {
+            if (_base) {
+                ::munmap(_base, _size);
+                _base = NULL;
+            }
+            if (_fd >= 0) {
+                if (::ftruncate(_fd, _cursor) != 0) {
+                    // keep the zero-filled tail; readers stop at it anyway
+                }
+                ::close(_fd);
+                _fd = -1;
+            }
+        }
+};
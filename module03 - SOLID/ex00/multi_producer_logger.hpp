@@ -0,0 +1,355 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "car.hpp"
+
+/*
+MultiProducerLogger: many threads log, one consumer writes, lines stay whole.
+
+    - every producer thread gets its own staging ring (single producer,
+      single consumer), registered on its first log; after that logging
+      touches no lock and no cache line shared with other producers
+    - the consumer thread drains all rings and writes to the sink in
+      timestamp order
+    - flush() waits until everything logged before the call was written
+
+A thread caches the rings of the last LOCAL_RINGS loggers it logged to,
+keyed by logger id (ids are never reused, so an entry of a destroyed
+logger is never matched, only evicted). Only a thread logging to more
+loggers than that in turn goes back to the registry mutex. A ring is
+retired once its thread has exited and the consumer has drained it, so
+threads that come and go do not leave rings behind to scan.
+
+The consumer parks on a condition variable without a timeout when every
+ring is empty and nothing is held back; producers take the mutex to wake it
+only when it is actually parked, as in AsyncLogger.
+
+Ordering: a producer publishes a "floor" (its previous timestamp) before
+reading the clock and clears it after pushing. The consumer only writes
+lines older than min(round start, all published floors); anything newer is
+held back for a later round, so a late producer can never be overtaken by a
+line stamped after its own.
+*/
+
+class MultiProducerLogger : public ILogger
+{
+    public:
+        MultiProducerLogger(ILogger* sink, std::size_t ring_capacity = 1024)
+            : _sink(sink), _id(_next_id()), _capacity(_round_up_pow2(ring_capacity)),
+              _retired_lines(0), _written(0), _running(true), _sleeping(false), _flushers(0), _seq(0) {
+            if (!_sink) {
+                throw std::runtime_error("Sink cannot be null");
+            }
+            _consumer = std::thread(&MultiProducerLogger::_run, this);
+        }
+
+        ~MultiProducerLogger() {
+            flush();
+            _running.store(false, std::memory_order_seq_cst);
+            _wake_consumer();
+            _consumer.join();
+        }
+
+        void log(const std::string &message) const {
+            write(message.data(), message.size());
+        }
+
+        void write(const char* data, std::size_t len) const {
+            Staging& s = _local_staging();
+            std::size_t tail = s.tail.load(std::memory_order_relaxed);
+            while (tail - s.head.load(std::memory_order_acquire) == _capacity) {
+                _wake_consumer();
+                std::this_thread::yield(); // ring full: wait for the consumer
+            }
+            s.floor.store(s.last_ts); // seq_cst: visible before the clock is read
+            uint64_t ts = _now();
+            Entry& e = s.ring[tail & (_capacity - 1)];
+            e.ts = ts;
+            e.line.assign(data, len);
+            s.tail.store(tail + 1, std::memory_order_release);
+            s.floor.store(IDLE);
+            s.last_ts = ts;
+            _wake_consumer();
+        }
+
+        void flush() const {
+            std::size_t target = 0;
+            {
+                std::lock_guard<std::mutex> lock(_registry_mutex);
+                target = _retired_lines;
+                for (std::size_t i = 0; i < _stagings.size(); ++i) {
+                    target += _stagings[i]->tail.load(std::memory_order_acquire);
+                }
+            }
+            _flushers.fetch_add(1, std::memory_order_seq_cst);
+            _wake_consumer();
+            std::unique_lock<std::mutex> lock(_wait_mutex);
+            _flushed.wait(lock, [this, target] { return _written.load(std::memory_order_seq_cst) >= target; });
+            _flushers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Threads with a ring: those that logged and have not exited, or whose lines are still queued.
+        std::size_t producers() const {
+            std::lock_guard<std::mutex> lock(_registry_mutex);
+            return _stagings.size();
+        }
+
+    private:
+        static const uint64_t IDLE = ~(uint64_t)0;
+
+        struct Entry {
+            uint64_t ts;
+            std::string line;
+        };
+
+        struct Pending {
+            uint64_t ts;
+            std::size_t seq; // arrival order, keeps each producer's lines in order on equal stamps
+            std::string line;
+            bool operator<(const Pending& o) const {
+                return ts != o.ts ? ts < o.ts : seq < o.seq;
+            }
+        };
+
+        // Producer-owned ring; the producer's fields and the consumer's head sit on separate cache lines.
+        struct Staging {
+            std::atomic<std::size_t> tail;
+            std::atomic<uint64_t> floor;
+            uint64_t last_ts;
+            char pad[64];
+            std::atomic<std::size_t> head;
+            std::vector<Entry> ring;
+            std::shared_ptr<const std::atomic<bool> > owner; // false once the producer thread has exited
+            Staging(std::size_t capacity, const std::shared_ptr<const std::atomic<bool> >& owner)
+                : tail(0), floor(IDLE), last_ts(0), head(0), ring(capacity), owner(owner) {}
+        };
+
+        static const std::size_t LOCAL_RINGS = 8;
+
+        // A thread's rings in the loggers it logged to last, by logger id (0: free).
+        struct LocalStagings {
+            std::size_t logger[LOCAL_RINGS];
+            Staging* staging[LOCAL_RINGS];
+            std::size_t next; // slot to reuse
+        };
+
+        // Lives as long as its thread; a ring outlives it only until drained.
+        struct ThreadAlive {
+            std::shared_ptr<std::atomic<bool> > alive;
+            ThreadAlive() : alive(std::make_shared<std::atomic<bool> >(true)) {}
+            ~ThreadAlive() { alive->store(false, std::memory_order_release); }
+        };
+
+        ILogger* _sink;
+        std::size_t _id;
+        std::size_t _capacity;
+        mutable std::mutex _registry_mutex;
+        mutable std::vector<std::unique_ptr<Staging> > _stagings;
+        mutable std::size_t _retired_lines; // lines ever pushed to rings since retired
+        mutable std::atomic<std::size_t> _written;
+        std::atomic<bool> _running;
+        mutable std::atomic<bool> _sleeping;            // the consumer is parked on _wake
+        mutable std::atomic<std::size_t> _flushers;     // threads waiting in flush()
+        mutable std::mutex _wait_mutex;
+        mutable std::condition_variable _wake;
+        mutable std::condition_variable _flushed;
+        std::vector<Pending> _pending;
+        std::vector<std::string> _spare; // buffers of written lines, handed back to the rings
+        std::size_t _seq;
+        std::thread _consumer;
+
+    private:
+        MultiProducerLogger(const MultiProducerLogger&);
+        MultiProducerLogger& operator=(const MultiProducerLogger&);
+
+        static std::size_t _next_id() {
+            static std::atomic<std::size_t> id(1);
+            return id.fetch_add(1);
+        }
+
+        static std::size_t _round_up_pow2(std::size_t n) {
+            std::size_t p = 2;
+            while (p < n) {
+                p <<= 1;
+            }
+            return p;
+        }
+
+        static uint64_t _now() {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        Staging& _local_staging() const {
+            static thread_local LocalStagings local = { {}, {}, 0 };
+            for (std::size_t i = 0; i < LOCAL_RINGS; ++i) {
+                if (local.logger[i] == _id) {
+                    return *local.staging[i];
+                }
+            }
+            static thread_local ThreadAlive self;
+            std::lock_guard<std::mutex> lock(_registry_mutex);
+            Staging* found = NULL;
+            for (std::size_t i = 0; i < _stagings.size() && !found; ++i) {
+                if (_stagings[i]->owner == self.alive) {
+                    found = _stagings[i].get();
+                }
+            }
+            if (!found) {
+                _stagings.push_back(std::unique_ptr<Staging>(new Staging(_capacity, self.alive)));
+                found = _stagings.back().get();
+            }
+            std::size_t slot = local.next++ % LOCAL_RINGS;
+            local.logger[slot] = _id;
+            local.staging[slot] = found;
+            return *found;
+        }
+
+        // Rings whose thread had exited before they were drained are empty for good.
+        void _retire(const std::vector<Staging*>& exited) {
+            if (exited.empty()) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(_registry_mutex);
+            for (std::size_t i = 0; i < exited.size(); ++i) {
+                for (std::size_t j = 0; j < _stagings.size(); ++j) {
+                    if (_stagings[j].get() == exited[i]) {
+                        _retired_lines += exited[i]->tail.load(std::memory_order_relaxed);
+                        _stagings.erase(_stagings.begin() + j);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Takes the mutex only if the consumer is parked; the fence pairs with the one in _park().
+        void _wake_consumer() const {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleeping.load(std::memory_order_relaxed) && _sleeping.exchange(false)) {
+                std::lock_guard<std::mutex> lock(_wait_mutex);
+                _wake.notify_one();
+            }
+        }
+
+        bool _rings_empty() const {
+            std::lock_guard<std::mutex> lock(_registry_mutex);
+            for (std::size_t i = 0; i < _stagings.size(); ++i) {
+                if (_stagings[i]->tail.load(std::memory_order_acquire)
+                    != _stagings[i]->head.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::size_t _drain(Staging& s) {
+            std::size_t head = s.head.load(std::memory_order_relaxed);
+            std::size_t tail = s.tail.load(std::memory_order_acquire);
+            for (std::size_t i = head; i != tail; ++i) {
+                Entry& e = s.ring[i & (_capacity - 1)];
+                _pending.push_back(Pending());
+                Pending& p = _pending.back();
+                p.ts = e.ts;
+                p.seq = _seq++;
+                p.line.swap(e.line);
+                if (!_spare.empty()) {
+                    e.line.swap(_spare.back()); // the slot gets a buffer with capacity back
+                    _spare.pop_back();
+                }
+            }
+            s.head.store(tail, std::memory_order_release);
+            return tail - head;
+        }
+
+        // One merge round; returns the number of lines written.
+        std::size_t _round() {
+            uint64_t watermark = _now();
+            std::vector<Staging*> stagings;
+            {
+                std::lock_guard<std::mutex> lock(_registry_mutex);
+                for (std::size_t i = 0; i < _stagings.size(); ++i) {
+                    stagings.push_back(_stagings[i].get());
+                }
+            }
+            std::vector<Staging*> exited;
+            for (std::size_t i = 0; i < stagings.size(); ++i) {
+                watermark = std::min(watermark, stagings[i]->floor.load());
+                if (!stagings[i]->owner->load(std::memory_order_acquire)) {
+                    exited.push_back(stagings[i]); // its last push is visible: this round drains it all
+                }
+            }
+            std::size_t drained = 0;
+            for (std::size_t i = 0; i < stagings.size(); ++i) {
+                drained += _drain(*stagings[i]);
+            }
+            _retire(exited);
+            if (_pending.empty()) {
+                return 0;
+            }
+            if (drained) {
+                std::sort(_pending.begin(), _pending.end());
+            }
+            std::size_t n = 0;
+            while (n < _pending.size() && _pending[n].ts < watermark) {
+                _sink->write(_pending[n].line.data(), _pending[n].line.size());
+                if (_spare.size() < _capacity) {
+                    _spare.push_back(std::string());
+                    _spare.back().swap(_pending[n].line);
+                }
+                ++n;
+            }
+            _pending.erase(_pending.begin(), _pending.begin() + n);
+            if (n) {
+                _written.fetch_add(n, std::memory_order_seq_cst);
+                if (_flushers.load(std::memory_order_seq_cst)) {
+                    std::lock_guard<std::mutex> lock(_wait_mutex);
+                    _flushed.notify_all();
+                }
+            }
+            return n;
+        }
+
+        // Sleeps until a producer, flush() or the destructor wakes it; no timeout.
+        void _park() {
+            std::unique_lock<std::mutex> lock(_wait_mutex);
+            _sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!_rings_empty() || !_running.load(std::memory_order_relaxed)) {
+                _sleeping.store(false, std::memory_order_relaxed);
+                return;
+            }
+            while (_sleeping.load(std::memory_order_relaxed)) {
+                _wake.wait(lock);
+            }
+        }
+
+        void _run() {
+            for (;;) {
+                if (_round()) {
+                    continue;
+                }
+                if (!_pending.empty()) {
+                    std::this_thread::yield(); // held back behind a producer's floor or this round's start
+                    continue;
+                }
+                if (!_running.load(std::memory_order_acquire)) {
+                    if (!_round() && _rings_empty()) {
+                        return;
+                    }
+                    continue;
+                }
+                _park();
+            }
+        }
+};
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <stdint.h>
+
+/*
+Record files: the layout shared by the binary log, command traces and the
+state journal. A RecordFileHeader (magic, version, record size), then the
+records, native byte order.
+
+RecordFileWriter appends to one through stdio. A failed write (disk full,
+I/O error) is sticky: stdio may already hold part of the bytes that
+failed, so nothing appended after them would line up with the records.
+The append() or flush() that hits the error throws, and so does every
+later one; the file ends inside the failed write. The destructor closes
+the file without throwing.
+*/
+
+struct RecordFileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+inline RecordFileHeader record_file_header(const char* magic, uint32_t version, uint32_t record_size)
+{
+    RecordFileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.record_size = record_size;
+    return header;
+}
+
+// Reads the header at the start of `file`; false unless it is exactly the one expected.
+inline bool read_record_file_header(std::FILE* file, const char* magic, uint32_t version, uint32_t record_size)
+{
+    RecordFileHeader header;
+    return std::fread(&header, sizeof(header), 1, file) == 1
+        && std::memcmp(header.magic, magic, sizeof(header.magic)) == 0
+        && header.version == version && header.record_size == record_size;
+}
+
+class RecordFileWriter
+{
+    public:
+        // `what` names the file in errors, e.g. "command trace".
+        RecordFileWriter(const std::string& path, const char* magic, uint32_t version, uint32_t record_size,
+                         const std::string& what)
+            : _file(std::fopen(path.c_str(), "wb")), _what(what), _failed(false) {
+            if (!_file) {
+                throw std::runtime_error("Cannot open " + what + ": " + path);
+            }
+            std::setvbuf(_file, NULL, _IOFBF, 1 << 16);
+            RecordFileHeader header = record_file_header(magic, version, record_size);
+            if (std::fwrite(&header, sizeof(header), 1, _file) != 1) {
+                std::fclose(_file);
+                throw std::runtime_error("Cannot write " + what + ": " + path);
+            }
+        }
+
+        ~RecordFileWriter() {
+            std::fclose(_file);
+        }
+
+        void append(const void* data, std::size_t bytes) {
+            if (!try_append(data, bytes)) {
+                _throw();
+            }
+        }
+
+        void flush() {
+            if (!try_flush()) {
+                _throw();
+            }
+        }
+
+        // As append() / flush(), for destructors: false instead of throwing.
+        bool try_append(const void* data, std::size_t bytes) {
+            if (_failed.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            if (bytes && std::fwrite(data, 1, bytes, _file) != bytes) {
+                _failed.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        bool try_flush() {
+            if (_failed.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            if (std::fflush(_file) != 0) {
+                _failed.store(true, std::memory_order_relaxed);
+                return false;
+            }
+            return true;
+        }
+
+        bool failed() const { return _failed.load(std::memory_order_relaxed); }
+
+        // Throws if a write has failed, e.g. before taking a record that could never be written.
+        void check() const {
+            if (failed()) {
+                _throw();
+            }
+        }
+
+    private:
+        std::FILE* _file;
+        std::string _what;
+        std::atomic<bool> _failed;
+
+    private:
+        void _throw() const {
+            throw std::runtime_error("Cannot write " + _what);
+        }
+
+        RecordFileWriter(const RecordFileWriter&);
+        RecordFileWriter& operator=(const RecordFileWriter&);
+};
@@ -0,0 +1,205 @@
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "work_stealing.hpp"
+
+/*
+Scenario: a script for a Car written as a C++20 coroutine that waits in
+simulated time.
+
+    Scenario brake_test(Car& car) {
+        car.start();
+        car.shift_gears_up();
+        car.apply_force_on_brakes(0);
+        car.accelerate(60);
+        co_await wait_for(std::chrono::seconds(2));
+        car.apply_force_on_brakes(80);
+    }
+
+    ScenarioScheduler scheduler(pool);
+    scheduler.spawn(brake_test(car));
+    scheduler.run();
+
+ScenarioScheduler keeps one bucket of suspended scenarios per wake time.
+A step jumps the clock to the earliest bucket and resumes its scenarios on
+a WorkStealingPool, CHUNK at a time, each until its next co_await; nothing
+sleeps in real time. A waiting scenario is only its coroutine frame, so
+hundreds of thousands fit on a few threads.
+
+Scenarios due at the same time may run in parallel: they must not share
+a Car, and their cars must log to a thread-safe logger. A scenario writes
+its next wake time into its own frame, and the scheduler files the
+resumed scenarios into their buckets alone after the step, in resume
+order, so the order of every bucket and the final state do not depend on
+the thread count. An exception thrown by a scenario ends it and is
+rethrown from step() once the step is done.
+
+Needs C++20 (see the bench/scenarios rule in the Makefile); nothing else
+here includes this header.
+*/
+
+typedef std::chrono::milliseconds SimDuration;
+
+class Scenario
+{
+    public:
+        struct promise_type {
+            uint64_t wake;               // simulated ms of the next resume
+            const uint64_t* clock;       // the scheduler's now, set by spawn()
+            std::exception_ptr error;
+
+            promise_type() : wake(0), clock(nullptr) {}
+
+            Scenario get_return_object() {
+                return Scenario(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            // Nothing runs before spawn(); a finished scenario stays suspended until the scheduler destroys it.
+            std::suspend_always initial_suspend() noexcept { return std::suspend_always(); }
+            std::suspend_always final_suspend() noexcept { return std::suspend_always(); }
+            void return_void() {}
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+        typedef std::coroutine_handle<promise_type> Handle;
+
+        Scenario(Scenario&& other) noexcept : _handle(std::exchange(other._handle, Handle())) {}
+
+        ~Scenario() {
+            if (_handle) {
+                _handle.destroy();
+            }
+        }
+
+        Handle release() {
+            return std::exchange(_handle, Handle());
+        }
+
+    private:
+        explicit Scenario(Handle handle) : _handle(handle) {}
+
+        Handle _handle;
+
+    private:
+        Scenario(const Scenario&);
+        Scenario& operator=(const Scenario&);
+};
+
+// co_await wait_for(d): resume `d` of simulated time later (a zero wait lets the other due scenarios run first).
+struct ScenarioWait {
+    SimDuration delay;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(Scenario::Handle handle) const noexcept {
+        Scenario::promise_type& p = handle.promise();
+        p.wake = *p.clock + (delay.count() > 0 ? (uint64_t)delay.count() : 0);
+    }
+    void await_resume() const noexcept {}
+};
+
+inline ScenarioWait wait_for(SimDuration delay) {
+    return ScenarioWait{delay};
+}
+
+class ScenarioScheduler
+{
+    public:
+        static const std::size_t CHUNK = 256;
+
+        ScenarioScheduler(WorkStealingPool& pool) : _pool(pool), _now(0), _live(0), _resumes(0) {}
+
+        ~ScenarioScheduler() {
+            for (std::map<uint64_t, std::vector<Scenario::Handle> >::iterator it = _buckets.begin();
+                 it != _buckets.end(); ++it) {
+                for (std::size_t i = 0; i < it->second.size(); ++i) {
+                    it->second[i].destroy();
+                }
+            }
+        }
+
+        // First resumed `delay` after the current time. Not from inside a scenario.
+        void spawn(Scenario scenario, SimDuration delay = SimDuration(0)) {
+            Scenario::Handle handle = scenario.release();
+            handle.promise().clock = &_now;
+            handle.promise().wake = _now + (delay.count() > 0 ? (uint64_t)delay.count() : 0);
+            _buckets[handle.promise().wake].push_back(handle);
+            ++_live;
+        }
+
+        SimDuration now() const { return SimDuration(_now); }
+        std::size_t live() const { return _live; }
+        std::size_t resumes() const { return _resumes; }
+
+        // Advances to the earliest wake time and runs every scenario due then;
+        // false if no scenario is left.
+        bool step() {
+            if (_buckets.empty()) {
+                return false;
+            }
+            std::map<uint64_t, std::vector<Scenario::Handle> >::iterator first = _buckets.begin();
+            _now = first->first;
+            _due.swap(first->second);
+            _buckets.erase(first);
+
+            _pool.run((_due.size() + CHUNK - 1) / CHUNK, *this);
+            _resumes += _due.size();
+
+            std::exception_ptr error;
+            for (std::size_t i = 0; i < _due.size(); ++i) {
+                Scenario::Handle handle = _due[i];
+                if (!handle.done()) {
+                    _buckets[handle.promise().wake].push_back(handle);
+                    continue;
+                }
+                if (handle.promise().error && !error) {
+                    error = handle.promise().error;
+                }
+                handle.destroy();
+                --_live;
+            }
+            _due.clear();
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return true;
+        }
+
+        // Steps until every scenario has finished.
+        void run() {
+            while (step()) {
+            }
+        }
+
+        // Steps while the earliest wake time is at most `until`.
+        void run_until(SimDuration until) {
+            while (!_buckets.empty() && _buckets.begin()->first <= (uint64_t)until.count()) {
+                step();
+            }
+        }
+
+        // One pool task: resumes the due scenarios of chunk `c`.
+        void operator()(std::size_t c) {
+            std::size_t end = (c + 1) * CHUNK < _due.size() ? (c + 1) * CHUNK : _due.size();
+            for (std::size_t i = c * CHUNK; i < end; ++i) {
+                _due[i].resume();
+            }
+        }
+
+    private:
+        WorkStealingPool& _pool;
+        std::map<uint64_t, std::vector<Scenario::Handle> > _buckets;   // wake time -> scenarios, spawn/resume order
+        std::vector<Scenario::Handle> _due;                              // the step's scenarios
+        uint64_t _now;                                                   // simulated ms
+        std::size_t _live;
+        std::size_t _resumes;
+
+    private:
+        ScenarioScheduler(const ScenarioScheduler&);
+        ScenarioScheduler& operator=(const ScenarioScheduler&);
+};
+const std::size_t ScenarioScheduler::CHUNK;
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "fleet.hpp"
+#include "vectorize.hpp"
+
+/*
+ShiftSchedule: the automatic's choice of forward gear, from speed and
+throttle, for every car in D.
+
+In forward gear g at road speed v the engine turns at
+
+    rpm = |v| * overall(g) * 60 / (2 pi wheel_radius)
+
+The car shifts up out of g once rpm passes the upshift point and down once
+it falls under the downshift point. Both points rise with throttle, so a
+cruising car shifts early and a car at full throttle holds its gears:
+
+    up(throttle)   = up_light   + throttle * (up_full   - up_light)
+    down(throttle) = down_light + throttle * (down_full - down_light)
+
+Per gear these become road speeds, again straight lines in throttle,
+computed once here. A downshift point must stay under the upshift point of
+the gear below, checked at construction, or a car would hunt between them.
+
+schedule() is the fleet kernel and has no branches: for each gear it
+counts, for every car, whether the car is past that gear's upshift line
+(the lowest gear it may be in) and not under the next gear's downshift
+line (the highest gear it may be in), then clamps the current gear between
+the two. Thresholds are broadcast constants, never per-car lookups, so the
+counting loops vectorize; a car may skip gears in one tick (kick-down).
+Cars not in D keep their forward gear. Like VehicleDynamics, it writes the
+forward gear column and logs nothing. choose() is the same decision for
+one car, written as the usual if / else.
+*/
+
+struct ShiftPoints {
+    float up_light, up_full;      // rpm at no / full throttle
+    float down_light, down_full;  // rpm at no / full throttle
+    float wheel_radius;           // m
+
+    ShiftPoints()
+        : up_light(2000), up_full(5500), down_light(1100), down_full(3000), wheel_radius(0.32f) {}
+};
+
+class ShiftSchedule
+{
+    public:
+        ShiftSchedule(const GearRatios& ratios = GearRatios(), const ShiftPoints& points = ShiftPoints())
+            : _gears(ratios.forward_gears) {
+            if (!(points.wheel_radius > 0) || !(points.down_light > 0)
+                || !(points.up_light <= points.up_full) || !(points.down_light <= points.down_full)) {
+                throw std::runtime_error("Shift points must be positive and rise with throttle");
+            }
+            const float rpm_to_speed = 2 * 3.14159265f * points.wheel_radius / 60;
+            for (int g = 1; g <= MAX_GEARS; ++g) {
+                bool used = g <= _gears;
+                float per_rpm = used ? rpm_to_speed / ratios.overall(g) : 0;
+                _up[g - 1] = points.up_light * per_rpm;
+                _up_span[g - 1] = (points.up_full - points.up_light) * per_rpm;
+                _down[g - 1] = points.down_light * per_rpm;
+                _down_span[g - 1] = (points.down_full - points.down_light) * per_rpm;
+                if (used && g > 1 && !(_down[g - 1] < _up[g - 2]
+                                       && _down[g - 1] + _down_span[g - 1] < _up[g - 2] + _up_span[g - 2])) {
+                    throw std::runtime_error("Downshift points must stay under the upshift point of the gear below");
+                }
+            }
+        }
+
+        int forward_gears() const { return _gears; }
+
+        // Road speeds in m/s.
+        float upshift_speed(int gear, float throttle) const {
+            return _up[gear - 1] + throttle * _up_span[gear - 1];
+        }
+
+        float downshift_speed(int gear, float throttle) const {
+            return _down[gear - 1] + throttle * _down_span[gear - 1];
+        }
+
+        // One car in D: the gear to be in after `gear`.
+        int choose(float speed, float throttle, int gear) const {
+            float v = speed < 0 ? -speed : speed;
+            while (gear < _gears && v > upshift_speed(gear, throttle)) {
+                ++gear;
+            }
+            while (gear > 1 && v < downshift_speed(gear, throttle)) {
+                --gear;
+            }
+            return gear;
+        }
+
+        // speed in m/s, throttle 0 .. 1, per car.
+        void step(Fleet& fleet, const float* speed, const float* throttle) const {
+            schedule(*this, speed, throttle, fleet.gear(), fleet.forward_gear(), 0, fleet.size());
+        }
+
+        CAR_VECTORIZE
+        static void schedule(const ShiftSchedule& s, const float* __restrict speed, const float* __restrict throttle,
+                             const uint8_t* __restrict selector, uint8_t* __restrict forward,
+                             std::size_t begin, std::size_t end) {
+            // Per strip: the gear bounds as floats, so the counting loops are float-only.
+            float lowest[BLOCK];
+            float highest[BLOCK];
+            float v[BLOCK];
+            const int gears = s._gears;
+            for (std::size_t base = begin; base < end; base += BLOCK) {
+                std::size_t n = end - base < BLOCK ? end - base : BLOCK;
+                const float* th = throttle + base;
+
+                for (std::size_t j = 0; j < n; ++j) {
+                    float x = speed[base + j];
+                    v[j] = x < 0 ? -x : x;
+                    lowest[j] = 1;
+                    highest[j] = 1;
+                }
+                for (int g = 1; g < gears; ++g) {
+                    const float up = s._up[g - 1], up_span = s._up_span[g - 1];
+                    const float down = s._down[g], down_span = s._down_span[g];
+                    for (std::size_t j = 0; j < n; ++j) {
+                        lowest[j] += (float)(v[j] > up + th[j] * up_span);
+                        highest[j] += (float)(v[j] >= down + th[j] * down_span);
+                    }
+                }
+                for (std::size_t j = 0; j < n; ++j) {
+                    std::size_t i = base + j;
+                    int current = forward[i];
+                    int lo = (int)lowest[j], hi = (int)highest[j];
+                    int chosen = current < lo ? lo : current > hi ? hi : current;
+                    forward[i] = (uint8_t)(selector[i] == D ? chosen : current);
+                }
+            }
+        }
+
+    private:
+        static const int MAX_GEARS = GearRatios::MAX_FORWARD_GEARS;
+        static const std::size_t BLOCK = 256;
+
+        int _gears;
+        float _up[MAX_GEARS];         // m/s at no throttle
+        float _up_span[MAX_GEARS];    // m/s added at full throttle
+        float _down[MAX_GEARS];
+        float _down_span[MAX_GEARS];
+};
+const int ShiftSchedule::MAX_GEARS;
+const std::size_t ShiftSchedule::BLOCK;
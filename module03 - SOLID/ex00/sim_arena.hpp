@@ -0,0 +1,223 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "car.hpp"
+#include "fleet.hpp"
+
+/*
+SimulationArena: the objects of one simulation, bump-allocated one after
+the other in one region.
+
+    arena.create<T>(args...)    constructs a T in place, returns T&
+    arena.reset()               ends every object at once; the region is
+                                kept for the next simulation
+
+Sized with the capacity the simulation needs (CarFactory::bytes_for), the
+region is a single allocation; past it the arena chains another block of
+at least the same size rather than fail. Objects are never freed one by
+one.
+
+reset() runs no destructor for types whose destructor releases nothing
+(ArenaTrivial: trivially destructible types, and the car types opted in
+below, whose parts hold only references and plain values), so tearing
+down a fleet of them is O(1). Any other type gets a finalizer, run newest
+first on reset().
+
+CarFactory builds cars in an arena: a standalone Car with its own parts
+(CarParts, laid out like main.cpp's stack objects), or a FleetCar over a
+fleet's columns.
+*/
+
+// True for types whose destructor may be skipped: it would release nothing.
+template <typename T> struct ArenaTrivial {
+    static const bool value = std::is_trivially_destructible<T>::value;
+};
+
+class SimulationArena
+{
+    public:
+        SimulationArena(std::size_t capacity = 1 << 20)
+            : _block_size(capacity ? capacity : 1), _current(0), _used(0), _finalizers(NULL) {
+            _blocks.push_back(Block(_block_size));
+        }
+
+        ~SimulationArena() {
+            reset();
+            for (std::size_t i = 0; i < _blocks.size(); ++i) {
+                ::operator delete(_blocks[i].data);
+            }
+        }
+
+        template <typename T, typename... Args>
+        T& create(Args&&... args) {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+            Finalizer* f = NULL;
+            if (!ArenaTrivial<T>::value) {
+                f = new (allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer();
+            }
+            T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+            if (f) {
+                f->destroy = &_destroy<T>;
+                f->object = object;
+                f->next = _finalizers;
+                _finalizers = f;
+            }
+            return *object;
+        }
+
+        // Raw, uninitialized storage; lives until reset().
+        void* allocate(std::size_t size, std::size_t align) {
+            std::size_t at = (_used + align - 1) & ~(align - 1);
+            if (at + size > _blocks[_current].size) {
+                _next_block(size + align);
+                at = (_used + align - 1) & ~(align - 1);
+            }
+            _used = at + size;
+            return _blocks[_current].data + at;
+        }
+
+        // Finalizers newest first, then back to an empty first block; extra blocks are returned.
+        void reset() {
+            for (Finalizer* f = _finalizers; f; f = f->next) {
+                f->destroy(f->object);
+            }
+            _finalizers = NULL;
+            for (std::size_t i = 1; i < _blocks.size(); ++i) {
+                ::operator delete(_blocks[i].data);
+            }
+            _blocks.erase(_blocks.begin() + 1, _blocks.end());
+            _current = 0;
+            _used = 0;
+        }
+
+        // Bytes handed out, padding included.
+        std::size_t used() const {
+            std::size_t n = _used;
+            for (std::size_t i = 0; i < _current; ++i) {
+                n += _blocks[i].size;
+            }
+            return n;
+        }
+
+        std::size_t capacity() const {
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < _blocks.size(); ++i) {
+                n += _blocks[i].size;
+            }
+            return n;
+        }
+
+        std::size_t blocks() const { return _blocks.size(); }
+
+    private:
+        struct Block {
+            char* data;
+            std::size_t size;
+            Block(std::size_t size) : data(static_cast<char*>(::operator new(size))), size(size) {}
+        };
+
+        struct Finalizer {
+            void (*destroy)(void*);
+            void* object;
+            Finalizer* next;
+        };
+
+        std::size_t _block_size;
+        std::vector<Block> _blocks;
+        std::size_t _current;     // block being filled
+        std::size_t _used;        // bytes used in it
+        Finalizer* _finalizers;   // newest first
+
+    private:
+        // The rest of the current block is given up; a block too small for `size` is skipped.
+        void _next_block(std::size_t size) {
+            while (++_current < _blocks.size() && _blocks[_current].size < size) {
+            }
+            if (_current == _blocks.size()) {
+                _blocks.push_back(Block(size > _block_size ? size : _block_size));
+            }
+            _used = 0;
+        }
+
+        template <typename T>
+        static void _destroy(void* object) {
+            static_cast<T*>(object)->~T();
+        }
+
+        SimulationArena(const SimulationArena&);
+        SimulationArena& operator=(const SimulationArena&);
+};
+
+// A standalone car: main.cpp's five objects as one.
+class CarParts
+{
+    public:
+        CarParts(ILogger* logger, ICarPolicy& policy, const GearRatios& ratios = GearRatios())
+            : engine(logger), transmission(logger, ratios), steering_system(logger), braking_system(logger),
+              car(logger, engine, transmission, steering_system, braking_system, policy) {}
+
+        Engine engine;
+        Transmission transmission;
+        SteeringSystem steering_system;
+        BrakingSystem braking_system;
+        Car car;
+
+    private:
+        CarParts(const CarParts&);
+        CarParts& operator=(const CarParts&);
+};
+
+/*
+The car types are not trivially destructible, only because of the empty
+virtual destructors of ILogger, IEngine & co. Their parts hold only
+references and plain values (a logger pointer, a RateLimiter, gear ratios,
+ints), so skipping their destructors releases nothing: each opts in below.
+A member that owns something (a string, a container, a smart pointer)
+breaks that invariant; its class must then drop its line here.
+*/
+template <> struct ArenaTrivial<Engine> { static const bool value = true; };
+template <> struct ArenaTrivial<Transmission> { static const bool value = true; };
+template <> struct ArenaTrivial<SteeringSystem> { static const bool value = true; };
+template <> struct ArenaTrivial<BrakingSystem> { static const bool value = true; };
+template <> struct ArenaTrivial<Car> { static const bool value = true; };
+template <> struct ArenaTrivial<FleetEngine> { static const bool value = true; };
+template <> struct ArenaTrivial<FleetTransmission> { static const bool value = true; };
+template <> struct ArenaTrivial<FleetSteeringSystem> { static const bool value = true; };
+template <> struct ArenaTrivial<FleetBrakingSystem> { static const bool value = true; };
+template <> struct ArenaTrivial<CarParts> { static const bool value = true; };
+template <> struct ArenaTrivial<FleetCar> { static const bool value = true; };
+
+class CarFactory
+{
+    public:
+        CarFactory(SimulationArena& arena, ILogger* logger, ICarPolicy& policy, const GearRatios& ratios = GearRatios())
+            : _arena(arena), _logger(logger), _policy(policy), _ratios(ratios) {}
+
+        // Arena capacity that holds `cars` standalone cars (or fleet cars) in one region.
+        static std::size_t bytes_for(std::size_t cars) {
+            std::size_t car = sizeof(CarParts) > sizeof(FleetCar) ? sizeof(CarParts) : sizeof(FleetCar);
+            return car * (cars ? cars : 1);
+        }
+
+        CarParts& create() {
+            return _arena.create<CarParts>(_logger, _policy, _ratios);
+        }
+
+        // Handles onto car `id` of `fleet`, logging to the fleet's logger.
+        FleetCar& create(Fleet& fleet, std::size_t id) {
+            return _arena.create<FleetCar>(fleet, id, _policy);
+        }
+
+        SimulationArena& arena() { return _arena; }
+
+    private:
+        SimulationArena& _arena;
+        ILogger* _logger;
+        ICarPolicy& _policy;
+        GearRatios _ratios;
+};
@@ -0,0 +1,387 @@
+#pragma once
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "record_file.hpp"
+
+/*
+StateJournal: event-sourced car state. Every change a part makes to its
+state (see StateRecorder and Fleet::journal_to in fleet.hpp) is appended
+to a binary journal as an 8-byte StateEvent: car, field, new value.
+
+    <path>          a record file (record_file.hpp) of StateEvents in
+                    append order
+    <path>.snap     a record file of snapshots: a JournalSnapshot and
+                    one column of `cars` bytes per StateField
+
+tick() closes the current tick with a marker event; every `snapshot_every`
+ticks the journal also writes the whole state as of that marker. Both
+files are append-only, native byte order.
+
+JournalReplay rebuilds the state as of the end of any closed tick: it
+loads the last snapshot at or before it and replays the events from
+there. Without the .snap file everything is replayed from the start,
+where every car is in its initial state (all fields 0: engine off, P).
+
+The journal keeps the current state in memory too (state()); cars are
+added as their first event arrives. One thread at a time may append.
+
+Once a write to either file has failed, the journal stops: append(), tick()
+and flush() throw from then on (see RecordFileWriter), and the events of
+the failed batch are lost rather than written out of line later.
+*/
+
+// One state change, or (field JOURNAL_TICK) the end of tick `car`.
+struct StateEvent {
+    uint32_t car;
+    uint16_t field;   // StateField, or JOURNAL_TICK
+    int16_t  value;
+};
+
+static_assert(sizeof(StateEvent) == 8, "StateEvent layout is part of the journal format");
+
+static const uint16_t JOURNAL_TICK = 0xFFFF;
+
+struct JournalSnapshot {
+    uint64_t tick;     // the state as of the end of this tick
+    uint64_t events;   // events (markers included) before the state was taken
+    uint64_t cars;
+};
+
+static const char STATE_JOURNAL_MAGIC[8] = { 'C', 'A', 'R', 'J', 'R', 'N', 'L', '\0' };
+static const char STATE_SNAPSHOT_MAGIC[8] = { 'C', 'A', 'R', 'S', 'N', 'A', 'P', '\0' };
+static const uint32_t STATE_JOURNAL_VERSION = 1;
+
+// Car state by field, one byte per car per field (the Fleet layout).
+class JournalState
+{
+    public:
+        JournalState() {}
+
+        std::size_t size() const { return _columns[0].size(); }
+
+        void resize(std::size_t cars) {
+            for (int f = 0; f < FIELD_COUNT; ++f) {
+                _columns[f].resize(cars, 0);
+            }
+        }
+
+        void clear() {
+            for (int f = 0; f < FIELD_COUNT; ++f) {
+                _columns[f].clear();
+            }
+        }
+
+        uint8_t* column(StateField field) { return _columns[field].data(); }
+        const uint8_t* column(StateField field) const { return _columns[field].data(); }
+
+        int value(std::size_t car, StateField field) const {
+            uint8_t v = _columns[field][car];
+            return field == FIELD_STEERING_ANGLE ? (int)(int8_t)v : (int)v;
+        }
+
+        void apply(uint32_t car, StateField field, int value) {
+            if (car >= size()) {
+                resize((std::size_t)car + 1);
+            }
+            _columns[field][car] = (uint8_t)value;
+        }
+
+    private:
+        std::vector<uint8_t> _columns[FIELD_COUNT];
+};
+
+class StateJournal : public IStateJournal
+{
+    public:
+        static const std::size_t BUFFER_EVENTS = 1 << 13;
+
+        StateJournal(const std::string& path, uint64_t snapshot_every = 64)
+            : _events(path, STATE_JOURNAL_MAGIC, STATE_JOURNAL_VERSION, sizeof(StateEvent), "state journal"),
+              _snapshots(path + ".snap", STATE_SNAPSHOT_MAGIC, STATE_JOURNAL_VERSION, FIELD_COUNT, "state journal"),
+              _snapshot_every(snapshot_every), _tick(0), _written(0) {
+            _buffer.reserve(BUFFER_EVENTS);
+        }
+
+        ~StateJournal() {
+            _events.try_append(_buffer.data(), _buffer.size() * sizeof(StateEvent));
+        }
+
+        void append(uint32_t car, StateField field, int value) {
+            if ((unsigned)field >= FIELD_COUNT) {
+                throw std::runtime_error("Unknown state field");
+            }
+            _state.apply(car, field, value);
+            _push(car, (uint16_t)field, (int16_t)value);
+        }
+
+        // Ends the current tick; every snapshot_every ticks (0: never) the state is snapshotted here.
+        void tick() {
+            _push((uint32_t)_tick, JOURNAL_TICK, 0);
+            ++_tick;
+            if (_snapshot_every && _tick % _snapshot_every == 0) {
+                _snapshot();
+            }
+        }
+
+        void flush() {
+            _write();
+            _events.flush();
+        }
+
+        uint64_t ticks() const { return _tick; }
+        uint64_t events() const { return _written + _buffer.size(); }
+        const JournalState& state() const { return _state; }
+
+    private:
+        RecordFileWriter _events;
+        RecordFileWriter _snapshots;
+        uint64_t _snapshot_every;
+        uint64_t _tick;
+        uint64_t _written;
+        std::vector<StateEvent> _buffer;
+        JournalState _state;
+
+    private:
+        void _push(uint32_t car, uint16_t field, int16_t value) {
+            _events.check();
+            _snapshots.check();
+            StateEvent e;
+            e.car = car;
+            e.field = field;
+            e.value = value;
+            _buffer.push_back(e);
+            if (_buffer.size() == BUFFER_EVENTS) {
+                _write();
+            }
+        }
+
+        // The batch leaves the buffer either way; if the write fails it is lost.
+        void _write() {
+            try {
+                _events.append(_buffer.data(), _buffer.size() * sizeof(StateEvent));
+            } catch (...) {
+                _buffer.clear();
+                throw;
+            }
+            _written += _buffer.size();
+            _buffer.clear();
+        }
+
+        // Events first: a snapshot never points past the end of the event file.
+        void _snapshot() {
+            flush();
+            JournalSnapshot s;
+            s.tick = _tick - 1;
+            s.events = _written;
+            s.cars = _state.size();
+            _snapshots.append(&s, sizeof(s));
+            for (int f = 0; f < FIELD_COUNT; ++f) {
+                _snapshots.append(_state.column((StateField)f), (std::size_t)s.cars);
+            }
+            _snapshots.flush();
+        }
+
+        StateJournal(const StateJournal&);
+        StateJournal& operator=(const StateJournal&);
+};
+const std::size_t StateJournal::BUFFER_EVENTS;
+
+// One car's fields, as returned by JournalReplay::car_at().
+struct JournalCarState {
+    int value[FIELD_COUNT];
+
+    int operator[](StateField field) const { return value[field]; }
+};
+
+// Reads back a journal written by StateJournal (which must have been flushed).
+class JournalReplay
+{
+    public:
+        static const std::size_t BLOCK_EVENTS = 1 << 16;
+
+        JournalReplay(const std::string& path)
+            : _events(_open(path, STATE_JOURNAL_MAGIC, sizeof(StateEvent), true)),
+              _snapshots(_open(path + ".snap", STATE_SNAPSHOT_MAGIC, FIELD_COUNT, false)), _count(0) {
+            std::fseek(_events, 0, SEEK_END);
+            _count = ((uint64_t)std::ftell(_events) - sizeof(RecordFileHeader)) / sizeof(StateEvent);
+            if (_snapshots) {
+                _index();
+            }
+        }
+
+        ~JournalReplay() {
+            std::fclose(_events);
+            if (_snapshots) {
+                std::fclose(_snapshots);
+            }
+        }
+
+        uint64_t events() const { return _count; }
+        std::size_t snapshots() const { return _index_entries.size(); }
+
+        // `out` becomes the state of every car as of the end of tick `tick`.
+        void rebuild(uint64_t tick, JournalState& out) {
+            const Entry* s = _nearest(tick);
+            out.clear();
+            uint64_t from = 0;
+            uint64_t current = 0;
+            if (s) {
+                out.resize((std::size_t)s->cars);
+                for (int f = 0; f < FIELD_COUNT; ++f) {
+                    _read_column(*s, (StateField)f, 0, out.column((StateField)f), (std::size_t)s->cars);
+                }
+                from = s->events;
+                current = s->tick + 1;
+            }
+            if (s && s->tick == tick) {
+                return;
+            }
+            _replay(from, current, tick, AllCars(out));
+        }
+
+        // Car `car` alone as of the end of tick `tick`: a few bytes of the snapshot, then its events.
+        JournalCarState car_at(uint64_t tick, uint32_t car) {
+            JournalCarState out;
+            std::memset(out.value, 0, sizeof(out.value));
+            const Entry* s = _nearest(tick);
+            uint64_t from = 0;
+            uint64_t current = 0;
+            if (s) {
+                for (int f = 0; f < FIELD_COUNT && car < s->cars; ++f) {
+                    uint8_t v;
+                    _read_column(*s, (StateField)f, car, &v, 1);
+                    out.value[f] = f == FIELD_STEERING_ANGLE ? (int)(int8_t)v : (int)v;
+                }
+                from = s->events;
+                current = s->tick + 1;
+            }
+            if (s && s->tick == tick) {
+                return out;
+            }
+            _replay(from, current, tick, OneCar(out, car));
+            return out;
+        }
+
+    private:
+        struct Entry {
+            uint64_t tick;
+            uint64_t events;
+            uint64_t cars;
+            long offset;      // of the first column in the .snap file
+        };
+
+        struct AllCars {
+            JournalState& state;
+            AllCars(JournalState& state) : state(state) {}
+            void operator()(const StateEvent& e) const {
+                state.apply(e.car, (StateField)e.field, e.value);
+            }
+        };
+
+        struct OneCar {
+            JournalCarState& state;
+            uint32_t car;
+            OneCar(JournalCarState& state, uint32_t car) : state(state), car(car) {}
+            void operator()(const StateEvent& e) const {
+                if (e.car == car) {
+                    state.value[e.field] = e.value;
+                }
+            }
+        };
+
+        std::FILE* _events;
+        std::FILE* _snapshots;
+        uint64_t _count;
+        std::vector<Entry> _index_entries;    // by tick
+        std::vector<StateEvent> _block;
+
+    private:
+        // Applies the events from `from` on, `current` being the tick they belong to, up to the end of `tick`.
+        template <typename Apply>
+        void _replay(uint64_t from, uint64_t current, uint64_t tick, const Apply& apply) {
+            if (std::fseek(_events, (long)(sizeof(RecordFileHeader) + from * sizeof(StateEvent)), SEEK_SET) != 0) {
+                throw std::runtime_error("Cannot seek in state journal");
+            }
+            _block.resize(BLOCK_EVENTS);
+            for (;;) {
+                std::size_t n = std::fread(_block.data(), sizeof(StateEvent), BLOCK_EVENTS, _events);
+                if (n == 0) {
+                    throw std::runtime_error("Tick is not in the state journal");
+                }
+                for (std::size_t i = 0; i < n; ++i) {
+                    const StateEvent& e = _block[i];
+                    if (e.field < FIELD_COUNT) {
+                        apply(e);
+                    } else if (e.field == JOURNAL_TICK && current++ == tick) {
+                        return;
+                    }
+                }
+            }
+        }
+
+        // Last snapshot at or before `tick`, or NULL.
+        const Entry* _nearest(uint64_t tick) const {
+            std::size_t lo = 0;
+            std::size_t hi = _index_entries.size();
+            while (lo < hi) {
+                std::size_t mid = (lo + hi) / 2;
+                if (_index_entries[mid].tick <= tick) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo ? &_index_entries[lo - 1] : NULL;
+        }
+
+        void _read_column(const Entry& s, StateField field, uint64_t first, uint8_t* out, std::size_t count) {
+            long at = s.offset + (long)(field * s.cars + first);
+            if (std::fseek(_snapshots, at, SEEK_SET) != 0 || std::fread(out, 1, count, _snapshots) != count) {
+                throw std::runtime_error("Cannot read state snapshot");
+            }
+        }
+
+        // Every snapshot up to the first one cut short or ahead of the events.
+        void _index() {
+            std::fseek(_snapshots, 0, SEEK_END);
+            long size = std::ftell(_snapshots);
+            long at = (long)sizeof(RecordFileHeader);
+            JournalSnapshot s;
+            while (std::fseek(_snapshots, at, SEEK_SET) == 0 && std::fread(&s, sizeof(s), 1, _snapshots) == 1) {
+                Entry e;
+                e.tick = s.tick;
+                e.events = s.events;
+                e.cars = s.cars;
+                e.offset = at + (long)sizeof(s);
+                at = e.offset + (long)(s.cars * FIELD_COUNT);
+                if (at > size || s.events > _count) {
+                    break;
+                }
+                _index_entries.push_back(e);
+            }
+        }
+
+        static std::FILE* _open(const std::string& path, const char* magic, uint32_t record_size, bool required) {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file) {
+                if (required) {
+                    throw std::runtime_error("Cannot open state journal: " + path);
+                }
+                return NULL;
+            }
+            if (!read_record_file_header(file, magic, STATE_JOURNAL_VERSION, record_size)) {
+                std::fclose(file);
+                throw std::runtime_error("Not a state journal: " + path);
+            }
+            return file;
+        }
+
+        JournalReplay(const JournalReplay&);
+        JournalReplay& operator=(const JournalReplay&);
+};
+const std::size_t JournalReplay::BLOCK_EVENTS;
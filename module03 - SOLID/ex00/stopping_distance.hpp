@@ -0,0 +1,170 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <stdint.h>
+
+#include "car.hpp"
+#include "dynamics.hpp"
+
+/*
+StoppingDistance: how far a car still rolls at a given speed and brake force.
+
+The answer is a table built once, by running VehicleDynamics' own speed
+update (engine off, not in Park) for every brake force 0 .. MAX_BRAKE_FORCE
+and every whole speed 0 .. SPEEDS - 1 m/s until the car stands still. So
+the prediction is what the simulation will actually do, drag, rolling
+resistance and the brake curve included. Between whole speeds the table
+is interpolated with a cubic through both rows and their slopes, which the
+model gives in closed form (v / deceleration at v); a query is four loads
+and a few multiply-adds. The rows cover the engine's top target speed
+(255 km/h, under 71 m/s); anything faster reads the last row.
+
+A query is not a bare table read: one within bench/stopping's tolerance
+(5 cm or 0.1%) would need rows every 0.005 m/s, about 5 MB instead of the
+64 KB here, and the cache misses would cost more than the cubic does.
+
+The build relies on the cars stopping: params need rolling > 0 (without
+it a coasting car only decays towards 0, through denormals, and never
+gets there), dt > 0 and drag >= 0. A car still moving after MAX_STEPS
+(over an hour at 60 Hz; a rolling resistance too small to change the
+speed in float does that) fails the build too.
+
+StoppingCarPolicy puts it in front of another policy: reverse is refused
+unless the car, braking as it is, stops within a given distance. One
+policy serves a whole fleet: it finds the car from its FleetBrakingSystem
+and reads its speed from VehicleDynamics on every query. A car outside
+that fleet has no known speed and is refused reverse.
+*/
+
+class StoppingDistance
+{
+    public:
+        static const int SPEEDS = 80;  // rows 0 .. 79 m/s
+        static const int FORCES = BrakingSystem::MAX_BRAKE_FORCE + 1;
+        static const int MAX_STEPS = 1 << 18;
+
+        StoppingDistance(const DynamicsParams& params = DynamicsParams()) {
+            if (!(params.rolling > 0) || !(params.dt > 0) || !(params.drag >= 0)) {
+                throw std::runtime_error("Stopping distances need rolling > 0, dt > 0 and drag >= 0");
+            }
+            const std::size_t cars = (std::size_t)FORCES * SPEEDS;
+            std::vector<uint8_t> zero(cars, 0), drive(cars, D), force(cars);
+            std::vector<int8_t> straight(cars, 0);
+            std::vector<float> speed(cars), distance(cars, 0.0f);
+            // Row f, speeds descending: the batch ends with the cars that stop first.
+            for (int f = 0; f < FORCES; ++f) {
+                for (int s = 0; s < SPEEDS; ++s) {
+                    force[f * SPEEDS + s] = (uint8_t)f;
+                    speed[f * SPEEDS + s] = (float)(SPEEDS - 1 - s);
+                }
+            }
+            DynamicsInputs in;
+            in.engine_active = zero.data();
+            in.target_speed = zero.data();
+            in.gear = drive.data();
+            in.brake_force = force.data();
+            in.steering_angle = straight.data();
+
+            int steps = 0;
+            for (std::size_t moving = cars; moving > 0; ) {
+                if (++steps > MAX_STEPS) {
+                    throw std::runtime_error("Stopping distances: the cars do not stop with these params");
+                }
+                VehicleDynamics::integrate(params, in, speed.data(), 0, moving);
+                for (std::size_t i = 0; i < moving; ++i) {
+                    distance[i] += (speed[i] < 0 ? -speed[i] : speed[i]) * params.dt;
+                }
+                // Stopped cars stay stopped (engine off, no speed to lose), so the tail can go.
+                while (moving > 0 && speed[moving - 1] == 0) {
+                    --moving;
+                }
+            }
+            for (int f = 0; f < FORCES; ++f) {
+                float decel = params.rolling + params.brakes.decel(f);
+                for (int s = 0; s < SPEEDS; ++s) {
+                    _table[f][SPEEDS - 1 - s] = distance[f * SPEEDS + s];
+                    // d distance / d speed = v / deceleration(v)
+                    _slope[f][s] = s / (decel + params.drag * s);
+                }
+            }
+        }
+
+        // Metres until standstill; the sign of speed does not matter.
+        float distance(float speed, int force) const {
+            float v = speed < 0 ? -speed : speed;
+            int f = force < 0 ? 0 : force >= FORCES ? FORCES - 1 : force;
+            int s = (int)v;
+            if (s >= SPEEDS - 1) {
+                return _table[f][SPEEDS - 1];
+            }
+            // Cubic Hermite between the two rows, with the slopes the model gives there.
+            float t = v - (float)s;
+            float d0 = _table[f][s], d1 = _table[f][s + 1];
+            float m0 = _slope[f][s], m1 = _slope[f][s + 1];
+            return d0 + t * (m0 + t * (3 * (d1 - d0) - 2 * m0 - m1 + t * (2 * (d0 - d1) + m0 + m1)));
+        }
+
+        void distance(const float* speed, const uint8_t* force, float* out, std::size_t count) const {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = distance(speed[i], force[i]);
+            }
+        }
+
+        bool stops_within(float speed, int force, float metres) const {
+            return distance(speed, force) <= metres;
+        }
+
+    private:
+        float _table[FORCES][SPEEDS];  // m
+        float _slope[FORCES][SPEEDS];  // m per m/s
+};
+const int StoppingDistance::SPEEDS;
+const int StoppingDistance::FORCES;
+const int StoppingDistance::MAX_STEPS;
+
+class StoppingCarPolicy : public ICarPolicy
+{
+    public:
+        // fleet's cars, moved by dynamics; both must outlive the policy.
+        StoppingCarPolicy(const ICarPolicy& base, const StoppingDistance& stopping,
+                          const Fleet& fleet, const VehicleDynamics& dynamics, float max_metres = 0.5f)
+            : _base(base), _stopping(stopping), _fleet(fleet), _dynamics(dynamics), _max_metres(max_metres) {}
+
+        bool can_start(const IEngine& engine, const ITransmission& transmission, const IBrakingSystem& braking_system) const {
+            return _base.can_start(engine, transmission, braking_system);
+        }
+
+        bool can_stop(const IEngine& engine, const ITransmission& transmission) const {
+            return _base.can_stop(engine, transmission);
+        }
+
+        bool can_accelerate(const IEngine& engine, const ITransmission& transmission, const IBrakingSystem& braking_system) const {
+            return _base.can_accelerate(engine, transmission, braking_system);
+        }
+
+        bool can_reverse(const IBrakingSystem& braking_system) const {
+            float speed;
+            return _base.can_reverse(braking_system)
+                && _speed_of(braking_system, speed)
+                && _stopping.stops_within(speed, braking_system.get_current_force(), _max_metres);
+        }
+
+    private:
+        const ICarPolicy& _base;
+        const StoppingDistance& _stopping;
+        const Fleet& _fleet;
+        const VehicleDynamics& _dynamics;
+        float _max_metres;
+
+        // Read per query, since resize() may move the speed column. A car not yet stepped is at rest.
+        bool _speed_of(const IBrakingSystem& braking_system, float& speed) const {
+            const FleetBrakingSystem* part = dynamic_cast<const FleetBrakingSystem*>(&braking_system);
+            if (!part || &part->fleet() != &_fleet) {
+                return false; // not one of the fleet's cars: its speed is unknown
+            }
+            std::size_t id = part->car_id();
+            speed = id < _dynamics.size() ? _dynamics.speed()[id] : 0.0f;
+            return true;
+        }
+};
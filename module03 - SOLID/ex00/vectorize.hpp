@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+CAR_VECTORIZE: put it on a function whose loop over fleet columns should be
+vectorized whatever the build flags.
+
+Clang vectorizes such loops at -O2 on its own. GCC's -O2 cost model leaves
+them scalar, and float selects only if-convert without trapping math, so
+the function gets those options, and on x86-64 an AVX2 clone picked at
+load time. Keep the loop free of
+std:: helpers: GCC does not inline across differing optimize attributes.
+*/
+
+#if defined(__GNUC__) && !defined(__clang__)
+# if defined(__x86_64__)
+#  define CAR_VECTORIZE __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic", "no-trapping-math"), \
+                                       target_clones("avx2", "default")))
+# else
+#  define CAR_VECTORIZE __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic", "no-trapping-math")))
+# endif
+#else
+# define CAR_VECTORIZE
+#endif
@@ -0,0 +1,188 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/*
+WorkStealingPool: run(count, task) calls task(i) once for every i in
+[0, count), on a fixed set of threads, and returns when all calls are done.
+
+Each worker owns a deque of task indices, handed out as one contiguous
+range per worker at the start of run(). A worker takes from the front of
+its own range; once empty it steals the back half of another worker's
+range, so an unlucky worker's tail is shared out instead of waited on.
+Tasks should be coarse (a chunk of cars, not one car): the deques are
+guarded by one small lock each, taken once per task.
+
+The caller of run() is worker 0, so a one-thread pool starts no thread at
+all. Which worker runs which task depends on timing; callers that need
+reproducible results make each task's output depend on `i` only (see
+FleetSimulator).
+*/
+
+class WorkStealingPool
+{
+    public:
+        // threads: workers including the caller of run(); 0 for one per hardware thread.
+        WorkStealingPool(std::size_t threads = 0)
+            : _count(threads ? threads : _hardware_threads()), _queues(new Queue[_count]),
+              _task(NULL), _context(NULL), _generation(0), _busy(0), _remaining(0), _steals(0), _running(true) {
+            for (std::size_t w = 1; w < _count; ++w) {
+                _threads.push_back(std::thread(&WorkStealingPool::_serve, this, w));
+            }
+        }
+
+        ~WorkStealingPool() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _running = false;
+            }
+            _wake.notify_all();
+            for (std::size_t i = 0; i < _threads.size(); ++i) {
+                _threads[i].join();
+            }
+        }
+
+        std::size_t threads() const { return _count; }
+
+        // Ranges taken from another worker since the pool started.
+        std::size_t steals() const { return _steals.load(std::memory_order_relaxed); }
+
+        // Not reentrant: one run() at a time, and not from inside a task.
+        template <typename F>
+        void run(std::size_t count, F& task) {
+            if (count == 0) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _task = &_call<F>;
+                _context = &task;
+                _remaining.store(count, std::memory_order_relaxed);
+                for (std::size_t w = 0; w < _count; ++w) {
+                    std::lock_guard<std::mutex> queue_lock(_queues[w].lock);
+                    _queues[w].begin = count * w / _count;
+                    _queues[w].end = count * (w + 1) / _count;
+                }
+                ++_generation;
+            }
+            _wake.notify_all();
+            _work(0);
+            std::unique_lock<std::mutex> lock(_mutex);
+            // Workers still looking for work would otherwise find the next run's deques.
+            _done.wait(lock, [this] { return _remaining.load(std::memory_order_acquire) == 0 && _busy == 0; });
+        }
+
+    private:
+        struct Queue {
+            std::mutex lock;
+            std::size_t begin;
+            std::size_t end;
+            char pad[64];  // keeps neighbouring workers' deques off one cache line
+
+            Queue() : begin(0), end(0) {}
+        };
+
+        typedef void (*TaskFn)(void*, std::size_t);
+
+        std::size_t _count;
+        std::unique_ptr<Queue[]> _queues;
+        std::vector<std::thread> _threads;
+
+        std::mutex _mutex;                 // guards the fields below, except the atomics
+        std::condition_variable _wake;     // a new run() or shutdown
+        std::condition_variable _done;     // a task or a worker finished
+        TaskFn _task;
+        void* _context;
+        unsigned long _generation;
+        std::size_t _busy;                 // workers (not counting the caller) inside _work()
+        std::atomic<std::size_t> _remaining;
+        std::atomic<std::size_t> _steals;
+        bool _running;
+
+    private:
+        template <typename F>
+        static void _call(void* task, std::size_t i) {
+            (*static_cast<F*>(task))(i);
+        }
+
+        void _serve(std::size_t self) {
+            unsigned long seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _wake.wait(lock, [this, seen] { return !_running || _generation != seen; });
+                    if (!_running) {
+                        return;
+                    }
+                    seen = _generation;
+                    ++_busy;
+                }
+                _work(self);
+                std::lock_guard<std::mutex> lock(_mutex);
+                --_busy;
+                _done.notify_all();
+            }
+        }
+
+        void _work(std::size_t self) {
+            std::size_t i;
+            while (_pop(self, i) || _steal(self, i)) {
+                _task(_context, i);
+                if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _done.notify_all();
+                }
+            }
+        }
+
+        bool _pop(std::size_t self, std::size_t& i) {
+            Queue& q = _queues[self];
+            std::lock_guard<std::mutex> lock(q.lock);
+            if (q.begin == q.end) {
+                return false;
+            }
+            i = q.begin++;
+            return true;
+        }
+
+        // Back half of the first non-empty deque after ours; its first index is run now, the rest queued.
+        bool _steal(std::size_t self, std::size_t& i) {
+            for (std::size_t k = 1; k < _count; ++k) {
+                Queue& victim = _queues[(self + k) % _count];
+                std::size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.lock);
+                    std::size_t left = victim.end - victim.begin;
+                    if (left == 0) {
+                        continue;
+                    }
+                    end = victim.end;
+                    begin = end - (left + 1) / 2;
+                    victim.end = begin;
+                }
+                _steals.fetch_add(1, std::memory_order_relaxed);
+                Queue& own = _queues[self];
+                std::lock_guard<std::mutex> lock(own.lock);
+                own.begin = begin + 1;
+                own.end = end;
+                i = begin;
+                return true;
+            }
+            return false;
+        }
+
+        static std::size_t _hardware_threads() {
+            unsigned n = std::thread::hardware_concurrency();
+            return n ? n : 1;
+        }
+
+    private:
+        WorkStealingPool(const WorkStealingPool&);
+        WorkStealingPool& operator=(const WorkStealingPool&);
+};